@@ -0,0 +1,35 @@
+# Sources of the ROS-free core (perception, planners, profiling, logs), built as the
+# findObject_core library by the rosbuild package (CMakeLists.txt) and by the standalone
+# build (perception/CMakeLists.txt). Every tool links it instead of listing sources.
+set(FINDOBJECT_LIB ${CMAKE_CURRENT_LIST_DIR}/../src/lib)
+set(FINDOBJECT_CORE_SOURCES
+    ${FINDOBJECT_LIB}/Tracer.cpp
+    ${FINDOBJECT_LIB}/Profiler.cpp
+    ${FINDOBJECT_LIB}/TaskScheduler.cpp
+    ${FINDOBJECT_LIB}/GeometryTypes.cpp
+    ${FINDOBJECT_LIB}/CameraCalibration.cpp
+    ${FINDOBJECT_LIB}/Pattern.cpp
+    ${FINDOBJECT_LIB}/PlanarPose.cpp
+    ${FINDOBJECT_LIB}/PatternDetector.cpp
+    ${FINDOBJECT_LIB}/HistogramVerifier.cpp
+    ${FINDOBJECT_LIB}/SquareDetector.cpp
+    ${FINDOBJECT_LIB}/DepthAnalysis.cpp
+    ${FINDOBJECT_LIB}/PlaneFit.cpp
+    ${FINDOBJECT_LIB}/ObjectPerception.cpp
+    ${FINDOBJECT_LIB}/OccupancyMap.cpp
+    ${FINDOBJECT_LIB}/FrontierPlanner.cpp
+    ${FINDOBJECT_LIB}/ViewpointPlanner.cpp
+    ${FINDOBJECT_LIB}/SearchBelief.cpp
+    ${FINDOBJECT_LIB}/ClearanceMap.cpp
+    ${FINDOBJECT_LIB}/GridPlanner.cpp
+    ${FINDOBJECT_LIB}/ExplorationGoals.cpp
+    ${FINDOBJECT_LIB}/ObservationMemory.cpp
+    ${FINDOBJECT_LIB}/ObjectPoseFilter.cpp
+    ${FINDOBJECT_LIB}/SyntheticScene.cpp
+    ${FINDOBJECT_LIB}/SensorLog.cpp)
+
+# gtest unit tests of the core, test/<name>.cpp
+set(FINDOBJECT_TESTS
+    test_HistogramVerifier
+    test_GeometryTypes
+    test_TaskScheduler)
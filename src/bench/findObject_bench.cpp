@@ -0,0 +1,770 @@
+/* * * * * * * * * * * * * * * * * * * *
+ * ========  FIND OBJECT BENCH  ======== *
+ *  Latency of the findObject kernels  *
+ * =================================== *
+ * * * * * * * * * * * * * * * * * * * */
+// usage: findObject_bench [--benchmark_filter=regex ...] [map.pgm ...]   (defaults to maps/arena*.pgm)
+// run from the package directory: the patterns are read from data/pattern.jpg and data/qr.jpg
+// Built on Google Benchmark when it is found (its --benchmark_* options apply), otherwise on a
+// plain timing loop with the iteration counts given below.
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <opencv2/opencv.hpp>
+#ifdef FINDOBJECT_HAVE_BENCHMARK
+#include <benchmark/benchmark.h>
+#include <regex>
+#endif
+
+#include "PatternDetector.hpp"
+#include "TaskScheduler.hpp"
+#include "HistogramVerifier.hpp"
+#include "SquareDetector.hpp"
+#include "DepthAnalysis.hpp"
+#include "PlaneFit.hpp"
+#include "Profiler.hpp"
+#include "OccupancyMap.hpp"
+#include "FrontierPlanner.hpp"
+#include "ClearanceMap.hpp"
+#include "GridPlanner.hpp"
+#include "ExplorationGoals.hpp"
+#include "ObservationMemory.hpp"
+#include "SearchBelief.hpp"
+
+namespace
+{
+#ifdef FINDOBJECT_HAVE_BENCHMARK
+    // one table for every case: the context is printed once and the names get a fixed width
+    class BenchReporter : public benchmark::ConsoleReporter
+    {
+        bool m_contextPrinted;
+
+    public:
+        BenchReporter() : m_contextPrinted(false) {}
+
+        bool ReportContext(const Context& context)
+        {
+            if (!m_contextPrinted)
+                m_contextPrinted = ConsoleReporter::ReportContext(context);
+            name_field_width_ = std::max<size_t>(60, context.name_field_width);
+            return true;
+        }
+    };
+
+    template <class F>
+    void runKernel(benchmark::State& state, F* f)
+    {
+        while (state.KeepRunning())
+            (*f)();
+    }
+
+    /**
+     * Time @f with Google Benchmark, which picks the number of iterations.
+     * Each case runs as soon as it is declared: its fixture is local to the caller, and some
+     * cases resize the TaskScheduler right before.
+     */
+    template <class F>
+    void bench(const std::string& name, F& f, int /*iterations*/)
+    {
+        // --benchmark_filter as Google Benchmark reads it, checked here so that the cases left
+        // out are not reported as unmatched one by one
+        static const std::string spec = benchmark::GetBenchmarkFilter();
+        static const bool negative = !spec.empty() && spec[0] == '-';
+        static const std::regex filter(negative ? spec.substr(1) : (spec == "all" ? "." : spec));
+        if (!spec.empty() && std::regex_search(name, filter) == negative)
+            return;
+
+        static BenchReporter reporter;
+        benchmark::RegisterBenchmark(name.c_str(), &runKernel<F>, &f)
+            ->Unit(benchmark::kMicrosecond)->UseRealTime();
+        benchmark::RunSpecifiedBenchmarks(&reporter);
+        benchmark::ClearRegisteredBenchmarks();
+    }
+#else
+    /**
+     * Time @iterations calls of @f and print mean, median and worst latency.
+     */
+    template <class F>
+    void bench(const std::string& name, F& f, int iterations)
+    {
+        std::vector<double> times(iterations);
+        for (int i = 0; i < iterations; i++) {
+            const int64 start = cv::getTickCount();
+            f();
+            times[i] = (cv::getTickCount() - start)*1e6/cv::getTickFrequency();
+        }
+
+        double sum = 0;
+        for (int i = 0; i < iterations; i++)
+            sum += times[i];
+        std::sort(times.begin(), times.end());
+
+        std::cout << std::left << std::setw(40) << name << std::right
+                  << " n=" << std::setw(6) << iterations << std::fixed << std::setprecision(2)
+                  << "  mean " << std::setw(10) << sum/iterations << " us"
+                  << "  median " << std::setw(10) << times[iterations/2] << " us"
+                  << "  max " << std::setw(10) << times.back() << " us" << std::endl;
+    }
+#endif
+
+    /**
+     * Read a map_server image with its default thresholds (negate 0, occupied 0.65, free 0.196).
+     */
+    bool loadMap(const std::string& file, cv::Mat& map)
+    {
+        cv::Mat img = cv::imread(file, 0);
+        if (img.empty())
+            return false;
+
+        map.create(img.size(), CV_8U);
+        for (int y = 0; y < img.rows; y++)
+            for (int x = 0; x < img.cols; x++) {
+                const double occ = (255 - img.at<uchar>(y,x))/255.0;
+                map.at<uchar>(y,x) = occ > 0.65 ? MAP_OCCUPIED : (occ < 0.196 ? MAP_FREE : MAP_UNKNOWN);
+            }
+        return true;
+    }
+
+    /**
+     * 640x480 BGR frame with @pattern under a random perspective warp (about a third of the
+     * frame), on a textured background, with sensor noise. @H gets the pattern to frame homography.
+     */
+    void makeScene(const cv::Mat& pattern, cv::RNG& rng, cv::Mat& scene, cv::Mat& H)
+    {
+        scene.create(480, 640, CV_8UC3);
+        rng.fill(scene, cv::RNG::UNIFORM, cv::Scalar::all(60), cv::Scalar::all(200));
+        cv::GaussianBlur(scene, scene, cv::Size(15, 15), 5);
+
+        const float s = 220.f/std::max(pattern.cols, pattern.rows);
+        const cv::Point2f c(rng.uniform(200.f, 440.f), rng.uniform(150.f, 330.f));
+        const float w = 0.5f*s*pattern.cols, h = 0.5f*s*pattern.rows;
+        const float j = 0.15f*std::min(w, h);
+        cv::Point2f src[4] = { cv::Point2f(0, 0), cv::Point2f(pattern.cols, 0),
+                               cv::Point2f(pattern.cols, pattern.rows), cv::Point2f(0, pattern.rows) };
+        cv::Point2f dst[4] = { c + cv::Point2f(-w, -h), c + cv::Point2f(w, -h),
+                               c + cv::Point2f(w, h), c + cv::Point2f(-w, h) };
+        for (int k = 0; k < 4; k++)
+            dst[k] += cv::Point2f(rng.uniform(-j, j), rng.uniform(-j, j));
+        H = cv::getPerspectiveTransform(src, dst);
+
+        cv::warpPerspective(pattern, scene, H, scene.size(), cv::INTER_LINEAR, cv::BORDER_TRANSPARENT);
+
+        cv::Mat noise(scene.size(), CV_16SC3);
+        rng.fill(noise, cv::RNG::NORMAL, cv::Scalar::all(0), cv::Scalar::all(4));
+        cv::Mat scene16;
+        scene.convertTo(scene16, CV_16SC3);
+        scene16 += noise;
+        scene16.convertTo(scene, CV_8UC3);
+    }
+
+    /**
+     * Occupancy values as in nav_msgs/OccupancyGrid (-1 unknown, 0 free, 100 occupied) of an 8 bits map.
+     */
+    void toOccupancyGrid(const cv::Mat& map, std::vector<signed char>& grid)
+    {
+        grid.resize(map.total());
+        for (int y = 0; y < map.rows; y++)
+            for (int x = 0; x < map.cols; x++) {
+                const uchar v = map.at<uchar>(y,x);
+                grid[y*map.cols + x] = v == MAP_FREE ? 0 : (v == MAP_OCCUPIED ? 100 : -1);
+            }
+    }
+
+    void randomFreeCells(const cv::Mat& map, cv::RNG& rng, int n, std::vector<cv::Point>& cells)
+    {
+        cells.clear();
+        for (int attempts = 0; (int)cells.size() < n && attempts < 1000*n; attempts++) {
+            const cv::Point c(rng.uniform(0, map.cols), rng.uniform(0, map.rows));
+            if (map.at<uchar>(c) == MAP_FREE)
+                cells.push_back(c);
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////
+    // Pattern detection
+
+    // exposes the protected kernels of the detector
+    class BenchDetector : public PatternDetector
+    {
+    public:
+        using PatternDetector::extractFeatures;
+        using PatternDetector::refineMatchesWithHomography;
+        using PatternDetector::getGray;
+    };
+
+    struct DetectorExtract {
+        const BenchDetector& detector; const cv::Mat& gray;
+        std::vector<cv::KeyPoint> keypoints; cv::Mat descriptors;
+        DetectorExtract(const BenchDetector& detector, const cv::Mat& gray) : detector(detector), gray(gray) {}
+        void operator()() { detector.extractFeatures(gray, keypoints, descriptors); }
+    };
+
+    struct DetectorTrain {
+        PatternDetector& detector; const std::vector<Pattern>& patterns;
+        DetectorTrain(PatternDetector& detector, const std::vector<Pattern>& patterns)
+            : detector(detector), patterns(patterns) {}
+        void operator()() { detector.train(patterns); }
+    };
+
+    struct DetectorFind {
+        PatternDetector& detector; const std::vector<cv::Mat>& scenes; size_t i; int found;
+        DetectorFind(PatternDetector& detector, const std::vector<cv::Mat>& scenes)
+            : detector(detector), scenes(scenes), i(0), found(0) {}
+        void operator()() {
+            PatternTrackingInfo info;
+            found += detector.findPattern(scenes[i % scenes.size()], info);
+            i++;
+        }
+    };
+
+    struct DetectorBatch {
+        const PatternDetector& detector; const std::vector<cv::Mat>& scenes; int found;
+        DetectorBatch(const PatternDetector& detector, const std::vector<cv::Mat>& scenes)
+            : detector(detector), scenes(scenes), found(0) {}
+        void operator()() {
+            std::vector<PatternTrackingInfo> infos;
+            std::vector<uchar> flags;
+            found += detector.findPatternBatch(scenes, infos, flags);
+        }
+    };
+
+    struct DetectorRefine {
+        const std::vector<cv::KeyPoint>& query; const std::vector<cv::KeyPoint>& train;
+        const std::vector<cv::DMatch>& matches;
+        DetectorRefine(const std::vector<cv::KeyPoint>& query, const std::vector<cv::KeyPoint>& train,
+                       const std::vector<cv::DMatch>& matches)
+            : query(query), train(train), matches(matches) {}
+        void operator()() {
+            std::vector<cv::DMatch> inliers(matches);
+            cv::Mat H;
+            BenchDetector::refineMatchesWithHomography(query, train, 3, inliers, H);
+        }
+    };
+
+    void benchPatterns(const std::vector<cv::Mat>& images)
+    {
+        BenchDetector detector;
+
+        // 1, 2 and 4 patterns: the images, then their mirrors
+        std::vector<cv::Mat> all(images);
+        for (size_t i = 0; i < images.size(); i++) {
+            cv::Mat mirror;
+            cv::flip(images[i], mirror, 1);
+            all.push_back(mirror);
+        }
+        std::vector<Pattern> patterns;
+        detector.buildPatternsFromImages(all, patterns);
+
+        // scenes of the first pattern
+        cv::RNG rng(17);
+        std::vector<cv::Mat> scenes(20);
+        for (size_t i = 0; i < scenes.size(); i++) {
+            cv::Mat H;
+            makeScene(images[0], rng, scenes[i], H);
+        }
+
+        cv::Mat gray;
+        BenchDetector::getGray(scenes[0], gray);
+        DetectorExtract extract(detector, gray);
+        bench("PatternDetector::extractFeatures(640x480)", extract, 50);
+        detector.extractionTiles = 3;
+        bench("PatternDetector::extractFeatures(640x480, 3 tiles)", extract, 50);
+        detector.extractionTiles = 1;
+
+        for (size_t n = 1; n <= patterns.size(); n *= 2) {
+            std::vector<Pattern> trained(patterns.begin(), patterns.begin() + n);
+            std::ostringstream count;
+            count << "(" << n << " patterns)";
+
+            DetectorTrain train(detector, trained);
+            bench("PatternDetector::train" + count.str(), train, 50);
+
+            for (int ratio = 0; ratio < 2; ratio++)
+                for (int refine = 0; refine < 2; refine++) {
+                    detector.train(trained);
+                    detector.enableRatioTest = ratio;
+                    detector.enableHomographyRefinement = refine;
+                    DetectorFind find(detector, scenes);
+                    bench(std::string("PatternDetector::findPattern") + (ratio ? "+ratio" : "") +
+                          (refine ? "+refine" : "") + count.str(), find, 40);
+                }
+        }
+
+        // throughput of the batch mode versus the number of threads sharing the trained model
+        detector.train(std::vector<Pattern>(patterns.begin(), patterns.begin() + 1));
+        detector.enableRatioTest = false;
+        detector.enableHomographyRefinement = true;
+        std::vector<cv::Mat> batch;
+        for (int k = 0; k < 4; k++)
+            batch.insert(batch.end(), scenes.begin(), scenes.end());
+        for (int threads = 1; threads <= cv::getNumberOfCPUs(); threads *= 2) {
+            TaskScheduler::init(threads - 1);
+            std::ostringstream name;
+            name << "PatternDetector::findPatternBatch(" << batch.size() << " frames, " << threads << " threads)";
+            DetectorBatch find(detector, batch);
+            bench(name.str(), find, 5);
+        }
+        TaskScheduler::init();
+
+        // matches of the first scene against the first pattern, with their outliers
+        std::vector<cv::DMatch> matches;
+        cv::BFMatcher(cv::NORM_HAMMING).match(extract.descriptors, patterns[0].descriptors, matches);
+        DetectorRefine refine(extract.keypoints, patterns[0].keypoints, matches);
+        bench("PatternDetector::refineMatchesWithHomography", refine, 200);
+    }
+
+    ////////////////////////////////////////////////////////////////////
+    // Square detection (ObjectFinder::detectObject)
+
+    struct SquaresFind {
+        const std::vector<cv::Mat>& scenes; size_t i;
+        SquaresFind(const std::vector<cv::Mat>& scenes) : scenes(scenes), i(0) {}
+        void operator()() {
+            std::vector<std::vector<cv::Point> > squares;
+            findSquares(scenes[i % scenes.size()], squares);
+            i++;
+        }
+    };
+
+    struct SquaresSelect {
+        const std::vector<std::vector<cv::Point> >& squares; const cv::Mat& scene;
+        const HistogramVerifier& verifier;
+        SquaresSelect(const std::vector<std::vector<cv::Point> >& squares, const cv::Mat& scene,
+                      const HistogramVerifier& verifier)
+            : squares(squares), scene(scene), verifier(verifier) {}
+        void operator()() { selectSquare(squares, scene, verifier); }
+    };
+
+    void benchSquares(const std::vector<cv::Mat>& images)
+    {
+        HistogramVerifier verifier;
+        verifier.setTemplate(images.back());
+
+        cv::RNG rng(19);
+        std::vector<cv::Mat> scenes(20);
+        for (size_t i = 0; i < scenes.size(); i++) {
+            cv::Mat H;
+            makeScene(images[i % images.size()], rng, scenes[i], H);
+        }
+
+        SquaresFind find(scenes);
+        bench("findSquares(640x480)", find, 50);
+
+        // the histogram step scales with the number of candidates: take the frame with the most
+        std::vector<std::vector<cv::Point> > squares, most;
+        size_t best = 0;
+        for (size_t i = 0; i < scenes.size(); i++) {
+            findSquares(scenes[i], squares);
+            if (squares.size() >= most.size()) {
+                most = squares;
+                best = i;
+            }
+        }
+        std::ostringstream name;
+        name << "selectSquare(" << most.size() << " candidates)";
+        SquaresSelect select(most, scenes[best], verifier);
+        bench(name.str(), select, 200);
+    }
+
+    ////////////////////////////////////////////////////////////////////
+    // Object yaw (ObjectFinder::findObjectYaw) and face plane
+
+    struct YawFit {
+        const cv::Mat& depth; const CameraCalibration& calibration; cv::Point offset; DepthFitMode mode;
+        YawFit(const cv::Mat& depth, const CameraCalibration& calibration, cv::Point offset, DepthFitMode mode)
+            : depth(depth), calibration(calibration), offset(offset), mode(mode) {}
+        void operator()() {
+            DepthLineFit fit;
+            fitDepthLine(depth, cv::Mat(), calibration, offset, fit, mode);
+        }
+    };
+
+    struct PlaneFitBench {
+        const cv::Mat& depth; const CameraCalibration& calibration; cv::Point offset; PlaneFitMode mode;
+        PlaneFitBench(const cv::Mat& depth, const CameraCalibration& calibration, cv::Point offset, PlaneFitMode mode)
+            : depth(depth), calibration(calibration), offset(offset), mode(mode) {}
+        void operator()() {
+            FacePlane plane;
+            fitDepthPlane(depth, cv::Mat(), offset, calibration, 0.001f, plane, mode);
+        }
+    };
+
+    void benchDepth()
+    {
+        // Kinect-like intrinsics, face 1.5 m away turned by 30 degrees, 5 mm of noise and 5% holes
+        CameraCalibration calibration(525, 525, 319.5, 239.5);
+        calibration.buildRayTable(cv::Size(640, 480));
+        const cv::Rect face(250, 170, 140, 140);
+
+        cv::RNG rng(23);
+        cv::Mat depth(480, 640, CV_16UC1, cv::Scalar(0));
+        const double slope = std::tan(CV_PI/6);
+        for (int v = face.y; v < face.br().y; v++)
+            for (int u = face.x; u < face.br().x; u++) {
+                const double xr = (u - 319.5)/525;
+                const double z = 1.5/(1 - slope*xr) + rng.gaussian(0.005);
+                depth.at<unsigned short>(v,u) = rng.uniform(0.f, 1.f) < 0.05 ? 0 : (unsigned short)(1000*z);
+            }
+        const cv::Mat roi(depth, face);
+
+        YawFit leastSquares(roi, calibration, face.tl(), DEPTH_FIT_LEAST_SQUARES);
+        bench("fitDepthLine(140x140)", leastSquares, 1000);
+        YawFit irls(roi, calibration, face.tl(), DEPTH_FIT_IRLS);
+        bench("fitDepthLine+irls(140x140)", irls, 1000);
+
+        PlaneFitBench pca(roi, calibration, face.tl(), PLANE_FIT_PCA);
+        bench("fitDepthPlane(140x140)", pca, 1000);
+        PlaneFitBench ransac(roi, calibration, face.tl(), PLANE_FIT_RANSAC);
+        bench("fitDepthPlane+ransac(140x140)", ransac, 200);
+    }
+
+    ////////////////////////////////////////////////////////////////////
+    // Map conversion (ObjectFinder::mapper and mapUpdater)
+
+    struct MapConvert {
+        const std::vector<signed char>& grid; cv::Size size; cv::Mat map;
+        MapConvert(const std::vector<signed char>& grid, cv::Size size) : grid(grid), size(size) {}
+        void operator()() { convertOccupancyGrid(&grid[0], size.width, size.height, map); }
+    };
+
+    struct MapPatch {
+        const std::vector<signed char>& patch; cv::Mat map; const std::vector<cv::Point>& cells; size_t i;
+        MapPatch(const std::vector<signed char>& patch, const cv::Mat& map, const std::vector<cv::Point>& cells)
+            : patch(patch), map(map.clone()), cells(cells), i(0) {}
+        void operator()() {
+            applyOccupancyPatch(&patch[0], cv::Rect(cells[i % cells.size()] - cv::Point(16, 16), cv::Size(32, 32)), map);
+            i++;
+        }
+    };
+
+    void benchMapper(const std::string& name, const cv::Mat& map)
+    {
+        cv::RNG rng(29);
+        std::vector<cv::Point> cells;
+        randomFreeCells(map, rng, 200, cells);
+        if (cells.empty())
+            return;
+
+        std::vector<signed char> grid;
+        toOccupancyGrid(map, grid);
+        MapConvert convert(grid, map.size());
+        bench(name + " convertOccupancyGrid", convert, 100);
+
+        std::vector<signed char> patch(32*32, 0);
+        MapPatch update(patch, map, cells);
+        bench(name + " applyOccupancyPatch(32x32)", update, 1000);
+    }
+
+    ////////////////////////////////////////////////////////////////////
+    // Exploration goals (ObjectFinder::pather)
+
+    struct FrontierUpdate {
+        FrontierPlanner& frontiers; const cv::Mat& map; cv::Rect dirty;
+        FrontierUpdate(FrontierPlanner& frontiers, const cv::Mat& map, const cv::Rect& dirty)
+            : frontiers(frontiers), map(map), dirty(dirty) {}
+        void operator()() { frontiers.update(map, dirty); }
+    };
+
+    struct FrontierRank {
+        const FrontierPlanner& frontiers; const cv::Mat& map; const std::vector<cv::Point>& cells; size_t i;
+        FrontierRank(const FrontierPlanner& frontiers, const cv::Mat& map, const std::vector<cv::Point>& cells)
+            : frontiers(frontiers), map(map), cells(cells), i(0) {}
+        void operator()() {
+            std::vector<FrontierCluster> clusters;
+            frontiers.rank(map, cells[i % cells.size()], clusters);
+            i++;
+        }
+    };
+
+    // the goals of one pather call, with two past viewpoints to revisit
+    struct PatherGoals {
+        const FrontierPlanner& frontiers; const GridPlanner& planner; const cv::Mat& map;
+        const std::vector<cv::Point>& cells; size_t i; cv::RNG rng;
+        PatherGoals(const FrontierPlanner& frontiers, const GridPlanner& planner, const cv::Mat& map,
+                    const std::vector<cv::Point>& cells)
+            : frontiers(frontiers), planner(planner), map(map), cells(cells), i(0), rng(37) {}
+        void operator()() {
+            const cv::Point start = cells[i % cells.size()];
+            std::vector<cv::Point> viewpoints;
+            viewpoints.push_back(cells[(i + 1) % cells.size()]);
+            viewpoints.push_back(cells[(i + 2) % cells.size()]);
+            ExplorationGoals goals;
+            selectExplorationGoals(map, frontiers, planner, start, cells[0], viewpoints, 4, rng, goals);
+            i++;
+        }
+    };
+
+    void benchPather(const std::string& name, const cv::Mat& map)
+    {
+        cv::RNG rng(31);
+        std::vector<cv::Point> cells;
+        randomFreeCells(map, rng, 50, cells);
+        if (cells.empty())
+            return;
+
+        FrontierPlanner frontiers;
+        FrontierUpdate full(frontiers, map, cv::Rect(0, 0, map.cols, map.rows));
+        bench(name + " FrontierPlanner::update(full)", full, 20);
+        FrontierUpdate local(frontiers, map, cv::Rect(cells[0] - cv::Point(16, 16), cv::Size(32, 32)));
+        bench(name + " FrontierPlanner::update(32x32)", local, 1000);
+
+        FrontierRank rank(frontiers, map, cells);
+        bench(name + " FrontierPlanner::rank", rank, 50);
+
+        GridPlanner planner;
+        planner.setMap(map);
+        PatherGoals goals(frontiers, planner, map, cells);
+        bench(name + " selectExplorationGoals", goals, 50);
+    }
+
+    ////////////////////////////////////////////////////////////////////
+    // Clearance
+
+    struct ClearanceSetMap {
+        ClearanceMap& clearance; const cv::Mat& map;
+        ClearanceSetMap(ClearanceMap& clearance, const cv::Mat& map) : clearance(clearance), map(map) {}
+        void operator()() { clearance.setMap(map); }
+    };
+
+    // toggle a small obstacle and update the distances around it, as a map update would
+    struct ClearanceUpdate {
+        ClearanceMap& clearance; cv::Mat map; const std::vector<cv::Point>& cells; size_t i;
+        ClearanceUpdate(ClearanceMap& clearance, const cv::Mat& map, const std::vector<cv::Point>& cells)
+            : clearance(clearance), map(map.clone()), cells(cells), i(0) {}
+        void operator()() {
+            const cv::Rect patch = cv::Rect(cells[i % cells.size()], cv::Size(3, 3)) & cv::Rect(0, 0, map.cols, map.rows);
+            map(patch).setTo(i % 2 ? MAP_FREE : MAP_OCCUPIED);
+            clearance.update(map, patch);
+            i++;
+        }
+    };
+
+    struct ClearanceApproach {
+        const ClearanceMap& clearance; const cv::Mat& map; const std::vector<cv::Point>& cells; size_t i;
+        ClearanceApproach(const ClearanceMap& clearance, const cv::Mat& map, const std::vector<cv::Point>& cells)
+            : clearance(clearance), map(map), cells(cells), i(0) {}
+        void operator()() {
+            std::vector<ApproachPose> poses;
+            clearance.findApproachPoses(map, cells[i % cells.size()], 0, 10, 4, poses);
+            i++;
+        }
+    };
+
+    void benchClearance(const std::string& name, const cv::Mat& map)
+    {
+        cv::RNG rng(7);
+        std::vector<cv::Point> cells;
+        randomFreeCells(map, rng, 200, cells);
+        if (cells.empty())
+            return;
+
+        ClearanceMap clearance;
+        clearance.maxDistance = 21;
+        ClearanceSetMap setMap(clearance, map);
+        bench(name + " ClearanceMap::setMap", setMap, 10);
+
+        ClearanceUpdate update(clearance, map, cells);
+        bench(name + " ClearanceMap::update(3x3)", update, 200);
+
+        clearance.setMap(map);
+        ClearanceApproach approach(clearance, map, cells);
+        bench(name + " ClearanceMap::findApproachPoses", approach, 1000);
+    }
+
+    ////////////////////////////////////////////////////////////////////
+    // Observation memory
+
+    struct MemoryNearest {
+        const ObservationMemory& memory; cv::RNG rng; int hits;
+        MemoryNearest(const ObservationMemory& memory) : memory(memory), rng(3), hits(0) {}
+        void operator()() {
+            Observation o;
+            hits += memory.nearest(cv::Point2f(rng.uniform(0.f, 100.f), rng.uniform(0.f, 100.f)), 0.5f, o);
+        }
+    };
+
+    void benchMemory()
+    {
+        // 10000 sightings spread over a 100 x 100 m area
+        ObservationMemory memory;
+        cv::RNG rng(5);
+        for (int i = 0; i < 10000; i++) {
+            Observation o;
+            o.position = cv::Point2f(rng.uniform(0.f, 100.f), rng.uniform(0.f, 100.f));
+            o.viewpoint = o.position;
+            o.yaw = o.viewYaw = 0;
+            o.stamp = i;
+            o.confidence = 1;
+            o.count = 1;
+            memory.add(o);
+        }
+
+        MemoryNearest nearest(memory);
+        bench("ObservationMemory::nearest", nearest, 100000);
+    }
+
+    ////////////////////////////////////////////////////////////////////
+    // Search belief
+
+    struct BeliefObserve {
+        SearchBelief& belief; const ViewpointPlanner& sensor; const cv::Mat& map;
+        const std::vector<cv::Point>& cells; size_t i;
+        BeliefObserve(SearchBelief& belief, const ViewpointPlanner& sensor, const cv::Mat& map,
+                      const std::vector<cv::Point>& cells)
+            : belief(belief), sensor(sensor), map(map), cells(cells), i(0) {}
+        void operator()() {
+            belief.observe(map, sensor, cells[i % cells.size()], 0.7*i);
+            i++;
+        }
+    };
+
+    struct BeliefSelect {
+        const SearchBelief& belief; const ViewpointPlanner& sensor; const cv::Mat& map;
+        const std::vector<cv::Point>& cells;
+        BeliefSelect(const SearchBelief& belief, const ViewpointPlanner& sensor, const cv::Mat& map,
+                     const std::vector<cv::Point>& cells)
+            : belief(belief), sensor(sensor), map(map), cells(cells) {}
+        void operator()() {
+            Viewpoint vp;
+            belief.selectBest(map, sensor, cells, cells[0], 0, cv::Mat(), vp, 0);
+        }
+    };
+
+    void benchBelief(const std::string& name, const cv::Mat& map)
+    {
+        cv::RNG rng(11);
+        std::vector<cv::Point> cells;
+        randomFreeCells(map, rng, 200, cells);
+        if (cells.empty())
+            return;
+
+        ViewpointPlanner sensor;
+        SearchBelief belief;
+        belief.reset(map.size());
+
+        BeliefObserve observe(belief, sensor, map, cells);
+        bench(name + " SearchBelief::observe", observe, 1000);
+
+        BeliefSelect select(belief, sensor, map, cells);
+        bench(name + " SearchBelief::selectBest(200x8)", select, 10);
+    }
+
+    ////////////////////////////////////////////////////////////////////
+    // Planner
+
+    struct PlannerSetMap {
+        GridPlanner& planner; const cv::Mat& map;
+        PlannerSetMap(GridPlanner& planner, const cv::Mat& map) : planner(planner), map(map) {}
+        void operator()() { planner.setMap(map); }
+    };
+
+    struct PlannerSameComponent {
+        const GridPlanner& planner; const std::vector<cv::Point>& cells; size_t i; int hits;
+        PlannerSameComponent(const GridPlanner& planner, const std::vector<cv::Point>& cells)
+            : planner(planner), cells(cells), i(0), hits(0) {}
+        void operator()() {
+            hits += planner.sameComponent(cells[i % cells.size()], cells[(i + 1) % cells.size()]);
+            i++;
+        }
+    };
+
+    struct PlannerFindPath {
+        const GridPlanner& planner; const std::vector<cv::Point>& cells; size_t i;
+        PlannerFindPath(const GridPlanner& planner, const std::vector<cv::Point>& cells)
+            : planner(planner), cells(cells), i(0) {}
+        void operator()() {
+            planner.findPath(cells[i % cells.size()], cells[(i + 1) % cells.size()]);
+            i++;
+        }
+    };
+
+    struct PlannerFilterGoals {
+        const GridPlanner& planner; const std::vector<cv::Point>& cells; size_t i;
+        PlannerFilterGoals(const GridPlanner& planner, const std::vector<cv::Point>& cells)
+            : planner(planner), cells(cells), i(0) {}
+        void operator()() {
+            std::vector<cv::Point> goals;
+            for (int k = 1; k <= 5; k++)
+                goals.push_back(cells[(i + k) % cells.size()]);
+            planner.filterGoals(cells[i % cells.size()], goals);
+            i++;
+        }
+    };
+
+    void benchPlanner(const std::string& name, const cv::Mat& map)
+    {
+        cv::RNG rng(42);
+        std::vector<cv::Point> cells;
+        randomFreeCells(map, rng, 200, cells);
+        if (cells.size() < 2) {
+            std::cout << name << ": not enough free cells" << std::endl;
+            return;
+        }
+
+        GridPlanner planner;
+        PlannerSetMap setMap(planner, map);
+        bench(name + " GridPlanner::setMap", setMap, 10);
+
+        PlannerSameComponent sameComponent(planner, cells);
+        bench(name + " GridPlanner::sameComponent", sameComponent, 100000);
+
+        PlannerFindPath findPath(planner, cells);
+        bench(name + " GridPlanner::findPath", findPath, 200);
+
+        PlannerFilterGoals filterGoals(planner, cells);
+        bench(name + " GridPlanner::filterGoals(5)", filterGoals, 50);
+    }
+}
+
+int main(int argc, char** argv)
+{
+#ifdef FINDOBJECT_HAVE_BENCHMARK
+    // takes the --benchmark_* options out of argv
+    benchmark::Initialize(&argc, argv);
+#endif
+    std::vector<std::string> maps;
+    for (int i = 1; i < argc; i++)
+        maps.push_back(argv[i]);
+    if (maps.empty()) {
+        maps.push_back("maps/arena2.pgm");
+        maps.push_back("maps/arena3.pgm");
+        maps.push_back("maps/arena_cube1.pgm");
+    }
+
+    // kernels alone, without the stage histograms
+    Profiler::setEnabled(false);
+
+    std::vector<cv::Mat> images;
+    const char* patternFiles[] = { "data/pattern.jpg", "data/qr.jpg" };
+    for (int i = 0; i < 2; i++) {
+        cv::Mat image = cv::imread(patternFiles[i]);
+        if (image.empty())
+            std::cerr << "Could not read " << patternFiles[i] << std::endl;
+        else
+            images.push_back(image);
+    }
+    if (!images.empty()) {
+        benchPatterns(images);
+        benchSquares(images);
+    }
+    benchDepth();
+    benchMemory();
+
+    for (size_t i = 0; i < maps.size(); i++) {
+        cv::Mat map;
+        if (!loadMap(maps[i], map)) {
+            std::cerr << "Could not read " << maps[i] << std::endl;
+            continue;
+        }
+        std::cout << maps[i] << " (" << map.cols << "x" << map.rows << ")" << std::endl;
+        benchMapper(maps[i], map);
+        benchPather(maps[i], map);
+        benchClearance(maps[i], map);
+        benchBelief(maps[i], map);
+        benchPlanner(maps[i], map);
+    }
+    return 0;
+}
@@ -0,0 +1,239 @@
+/* * * * * * * * * * * * * * * * * * * *
+ * ========  FIND OBJECT SWEEP  ======== *
+ *  PatternDetector speed and accuracy  *
+ * =================================== *
+ * * * * * * * * * * * * * * * * * * * */
+// usage: findObject_sweep [-n samples] [-s seed] [-t template ...] [-o out_dir | -d dataset_dir] [background ...]
+//   -n  number of synthetic frames (default 200)
+//   -s  seed of the generator (default 1)
+//   -t  template image, repeatable (default data/pattern.jpg and data/qr.jpg)
+//   -o  also write the generated frames and their ground truth to out_dir
+//   -d  read the frames from dataset_dir (written by -o) instead of generating them
+// One CSV line per detector configuration is written to the standard output.
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <cmath>
+#include <cfloat>
+#include <opencv2/opencv.hpp>
+
+#include "PatternDetector.hpp"
+#include "SyntheticScene.hpp"
+#include "Profiler.hpp"
+#include "TaskScheduler.hpp"
+
+namespace
+{
+    // a detection is correct when it finds the rendered template within this corner RMSE
+    const double MAX_CORNER_ERROR = 10.0;
+
+    struct DetectorConfig
+    {
+        int   features;
+        float threshold;
+        bool  ratioTest;
+        bool  refinement;
+    };
+
+    struct SampleResult
+    {
+        bool   found;
+        bool   correct;
+        double rmse;    // pixels, when found
+        double ms;
+    };
+
+    double cornerRMSE(const std::vector<cv::Point2f>& found, const std::vector<cv::Point2f>& truth)
+    {
+        if (found.size() != truth.size() || truth.empty())
+            return DBL_MAX;
+        double sum = 0;
+        for (size_t k = 0; k < truth.size(); k++) {
+            const cv::Point2f d = found[k] - truth[k];
+            sum += d.x*d.x + d.y*d.y;
+        }
+        return std::sqrt(sum/truth.size());
+    }
+
+    PatternDetector makeDetector(const DetectorConfig& config)
+    {
+        PatternDetector detector(new cv::ORB(config.features), new cv::ORB(config.features), config.ratioTest);
+        detector.enableHomographyRefinement = config.refinement;
+        detector.homographyReprojectionThreshold = config.threshold;
+        return detector;
+    }
+
+    /**
+     * Runs one configuration over a range of samples. The trained detector is shared,
+     * every chunk has its own workspace.
+     */
+    class SweepBody : public cv::ParallelLoopBody {
+        const PatternDetector& detector;
+        const std::vector<SyntheticSample>& samples;
+        std::vector<SampleResult>& results;
+
+    public:
+        SweepBody(const PatternDetector& detector, const std::vector<SyntheticSample>& samples,
+                  std::vector<SampleResult>& results)
+            : detector(detector), samples(samples), results(results) {}
+
+        void operator() (const cv::Range& range) const {
+            PatternDetector::Workspace workspace;
+
+            for (int i = range.start; i != range.end; i++) {
+                const SyntheticSample& sample = samples[i];
+                PatternTrackingInfo info;
+
+                const int64 start = cv::getTickCount();
+                const bool found = detector.findPattern(sample.image, info, workspace);
+                SampleResult& r = results[i];
+                r.ms = (cv::getTickCount() - start)*1e3/cv::getTickFrequency();
+
+                r.found = found;
+                r.rmse = found ? cornerRMSE(info.points2d, sample.corners) : DBL_MAX;
+                r.correct = found && info.patternIdx == sample.patternIdx && r.rmse < MAX_CORNER_ERROR;
+            }
+        }
+    };
+
+    double stageMean(const std::vector<StageStats>& stats, const std::string& name)
+    {
+        for (size_t i = 0; i < stats.size(); i++)
+            if (stats[i].name == name)
+                return stats[i].mean;
+        return 0;
+    }
+
+    void runConfig(const DetectorConfig& config, const std::vector<cv::Mat>& templates,
+                   const std::vector<SyntheticSample>& samples)
+    {
+        // the patterns depend on the feature extractor of the configuration
+        PatternDetector detector = makeDetector(config);
+        std::vector<Pattern> patterns;
+        detector.buildPatternsFromImages(templates, patterns);
+        detector.train(patterns);
+
+        std::vector<SampleResult> results(samples.size());
+        Profiler::reset();
+        TaskScheduler::parallelFor(cv::Range(0, samples.size()), SweepBody(detector, samples, results));
+
+        int correct = 0, wrong = 0;
+        double squared = 0;
+        std::vector<double> times(results.size());
+        double total = 0;
+        for (size_t i = 0; i < results.size(); i++) {
+            const SampleResult& r = results[i];
+            if (r.correct) {
+                correct++;
+                squared += r.rmse*r.rmse;
+            } else if (r.found) {
+                wrong++;
+            }
+            times[i] = r.ms;
+            total += r.ms;
+        }
+        std::sort(times.begin(), times.end());
+
+        std::vector<StageStats> stats;
+        Profiler::summary(stats);
+
+        const double n = std::max<size_t>(results.size(), 1);
+        std::cout << config.features << "," << config.threshold << ","
+                  << config.ratioTest << "," << config.refinement << ","
+                  << results.size() << "," << std::fixed << std::setprecision(4)
+                  << correct/n << "," << wrong/n << ","
+                  << (correct ? std::sqrt(squared/correct) : 0.0) << ","
+                  << total/n << "," << times[times.size()/2] << "," << times[size_t(0.95*(times.size() - 1))] << ","
+                  << stageMean(stats, "findPattern.extract") << ","
+                  << stageMean(stats, "findPattern.match") << ","
+                  << stageMean(stats, "findPattern.ransac") << ","
+                  << stageMean(stats, "findPattern.refine")
+                  << std::endl;
+        std::cout.unsetf(std::ios::fixed);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int count = 200;
+    uint64 seed = 1;
+    std::string outDir, datasetDir;
+    std::vector<std::string> templateFiles, backgroundFiles;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "-n" && i + 1 < argc)
+            count = std::atoi(argv[++i]);
+        else if (arg == "-s" && i + 1 < argc)
+            seed = std::strtoul(argv[++i], 0, 10);
+        else if (arg == "-t" && i + 1 < argc)
+            templateFiles.push_back(argv[++i]);
+        else if (arg == "-o" && i + 1 < argc)
+            outDir = argv[++i];
+        else if (arg == "-d" && i + 1 < argc)
+            datasetDir = argv[++i];
+        else
+            backgroundFiles.push_back(arg);
+    }
+    if (templateFiles.empty()) {
+        templateFiles.push_back("data/pattern.jpg");
+        templateFiles.push_back("data/qr.jpg");
+    }
+
+    std::vector<cv::Mat> templates, backgrounds;
+    for (size_t i = 0; i < templateFiles.size(); i++) {
+        templates.push_back(cv::imread(templateFiles[i]));
+        if (templates.back().empty()) {
+            std::cerr << "Could not read " << templateFiles[i] << std::endl;
+            return 1;
+        }
+    }
+    for (size_t i = 0; i < backgroundFiles.size(); i++) {
+        cv::Mat bg = cv::imread(backgroundFiles[i]);
+        if (bg.empty())
+            std::cerr << "Could not read " << backgroundFiles[i] << ", skipped" << std::endl;
+        else
+            backgrounds.push_back(bg);
+    }
+
+    std::vector<SyntheticSample> samples;
+    if (!datasetDir.empty()) {
+        SyntheticSample sample;
+        for (int i = 0; i < count && loadSample(datasetDir, i, sample); i++)
+            samples.push_back(sample);
+    } else {
+        SceneGenerator generator(templates, backgrounds, SceneParams(), seed);
+        generator.renderAll(count, samples);
+        for (size_t i = 0; !outDir.empty() && i < samples.size(); i++)
+            if (!saveSample(outDir, i, samples[i])) {
+                std::cerr << "Could not write to " << outDir << std::endl;
+                return 1;
+            }
+    }
+    if (samples.empty()) {
+        std::cerr << "No samples" << std::endl;
+        return 1;
+    }
+    std::cerr << samples.size() << " samples" << std::endl;
+
+    // configuration grid
+    const int   features[]   = { 300, 500, 800, 1200, 2000 };
+    const float thresholds[] = { 1.5f, 3.0f, 5.0f, 8.0f };
+
+    std::cout << "features,threshold,ratio_test,refinement,samples,detection_rate,false_rate,corner_rmse_px,"
+                 "mean_ms,p50_ms,p95_ms,extract_ms,match_ms,ransac_ms,refine_ms" << std::endl;
+    for (size_t f = 0; f < sizeof(features)/sizeof(features[0]); f++)
+        for (size_t t = 0; t < sizeof(thresholds)/sizeof(thresholds[0]); t++)
+            for (int ratio = 0; ratio < 2; ratio++)
+                for (int refine = 0; refine < 2; refine++) {
+                    DetectorConfig config;
+                    config.features = features[f];
+                    config.threshold = thresholds[t];
+                    config.ratioTest = ratio;
+                    config.refinement = refine;
+                    runConfig(config, templates, samples);
+                }
+    return 0;
+}
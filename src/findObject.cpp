@@ -11,6 +11,7 @@
 int main(int argc, char** argv){
     // Initialize classes and configurations
     ros::init(argc, argv, "findObject");
+    ObjectFinder::initProcess(true);
     ObjectFinder f;
     f.applyAction();
     return 0;
@@ -0,0 +1,71 @@
+/* * * * * * * * * * * * * * * * * * * *
+ * =======  FIND OBJECT NODELET  ====== *
+ *  ObjectFinder in a nodelet manager  *
+ * =================================== *
+ * * * * * * * * * * * * * * * * * * * */
+// Loaded in the manager of the camera driver, the RGB and depth frames are handed over as
+// shared pointers instead of being serialized (see launch/findObject_nodelet.launch).
+// Same parameters as the findObject node.
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include "_nodeSM.hpp"
+
+namespace findObject
+{
+
+class ObjectFinderNodelet : public nodelet::Nodelet
+{
+public:
+    ObjectFinderNodelet() : stopping(false) {}
+
+    ~ObjectFinderNodelet()
+    {
+        {
+            boost::mutex::scoped_lock lock(mutex);
+            stopping = true;
+            if (finder)
+                finder->requestStop();
+            else
+                thread.interrupt(); // still waiting for move_base in the constructor
+        }
+        thread.join();
+    }
+
+private:
+    virtual void onInit()
+    {
+        // the manager is shared: no signal handler, and the pool is only started by the first one
+        ObjectFinder::initProcess(false);
+        // the state machine has its own loop: run it on its own thread, onInit must return
+        thread = boost::thread(&ObjectFinderNodelet::run, this);
+    }
+
+    void run()
+    {
+        try {
+            ObjectFinder* f = new ObjectFinder(getNodeHandle());
+            {
+                boost::mutex::scoped_lock lock(mutex);
+                finder.reset(f);
+                if (stopping)
+                    return;
+            }
+            f->applyAction();
+        } catch (boost::thread_interrupted&) {
+            // unloaded before it was ready
+        }
+    }
+
+    boost::mutex mutex;
+    bool stopping;
+    boost::scoped_ptr<ObjectFinder> finder;
+    boost::thread thread;
+};
+
+}
+
+PLUGINLIB_EXPORT_CLASS(findObject::ObjectFinderNodelet, nodelet::Nodelet)
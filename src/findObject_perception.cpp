@@ -0,0 +1,223 @@
+/* * * * * * * * * * * * * * * * * * * *
+ * =====  FIND OBJECT PERCEPTION  ===== *
+ *  Offline detection on RGB-D frames  *
+ * =================================== *
+ * * * * * * * * * * * * * * * * * * * */
+// usage: findObject_perception -r rgb_dir [-d depth_dir] [-t template] [-c fx,fy,cx,cy]
+//                              [-j threads] [-a] [-p] [-o out.csv]
+//   -r  directory of the color frames, processed in file name order
+//   -d  directory of the depth frames (16 bit millimeters or float meters), paired with the
+//       color frames by file name without extension; frames without depth are only detected
+//   -t  template image of the object face (default data/pattern.jpg)
+//   -c  camera intrinsics (default 525,525,319.5,239.5)
+//   -j  number of threads (default: number of CPUs)
+//   -a  pin the threads to CPUs
+//   -p  also run the feature-based pattern detector
+//   -o  CSV output (default: standard output)
+// Does not need ROS: the pipeline is the one of the node (ObjectPerception).
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <map>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <dirent.h>
+#include <opencv2/opencv.hpp>
+
+#include "ObjectPerception.hpp"
+#include "Profiler.hpp"
+#include "TaskScheduler.hpp"
+
+namespace
+{
+    struct Frame
+    {
+        std::string name;
+        std::string rgbFile;
+        std::string depthFile;  // empty if none
+    };
+
+    struct FrameResult
+    {
+        PerceptionResult result;
+        bool             read;
+        double           ms;
+    };
+
+    std::string stem(const std::string& file)
+    {
+        const size_t dot = file.rfind('.');
+        return dot == std::string::npos ? file : file.substr(0, dot);
+    }
+
+    bool listDirectory(const std::string& dir, std::vector<std::string>& files)
+    {
+        DIR* d = opendir(dir.c_str());
+        if (!d)
+            return false;
+        for (struct dirent* e = readdir(d); e; e = readdir(d))
+            if (e->d_name[0] != '.')
+                files.push_back(e->d_name);
+        closedir(d);
+        std::sort(files.begin(), files.end());
+        return true;
+    }
+
+    /**
+     * One task per frame on the TaskScheduler, all sharing the same trained pipeline; the
+     * parallel stages of the pipeline run nested on the same threads.
+     */
+    class FrameBody : public cv::ParallelLoopBody {
+        const std::vector<Frame>& frames;
+        std::vector<FrameResult>& results;
+        const ObjectPerception& perception;
+
+    public:
+        FrameBody(const std::vector<Frame>& frames, std::vector<FrameResult>& results,
+                  const ObjectPerception& perception)
+            : frames(frames), results(results), perception(perception) {}
+
+        void operator() (const cv::Range& range) const {
+            for (int i = range.start; i != range.end; i++) {
+                FrameResult& r = results[i];
+                const cv::Mat bgr = cv::imread(frames[i].rgbFile);
+                const cv::Mat depth = frames[i].depthFile.empty() ? cv::Mat() : cv::imread(frames[i].depthFile, -1);
+                r.read = !bgr.empty();
+                if (!r.read)
+                    continue;
+
+                const int64 start = cv::getTickCount();
+                perception.process(bgr, depth, r.result);
+                r.ms = (cv::getTickCount() - start)*1e3/cv::getTickFrequency();
+            }
+        }
+    };
+}
+
+int main(int argc, char** argv)
+{
+    std::string rgbDir, depthDir, templFile = "data/pattern.jpg", outFile;
+    float fx = 525, fy = 525, cx = 319.5f, cy = 239.5f;
+    int threads = cv::getNumberOfCPUs();
+    bool affinity = false;
+    PerceptionParams params;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "-r" && i + 1 < argc)
+            rgbDir = argv[++i];
+        else if (arg == "-d" && i + 1 < argc)
+            depthDir = argv[++i];
+        else if (arg == "-t" && i + 1 < argc)
+            templFile = argv[++i];
+        else if (arg == "-c" && i + 1 < argc) {
+            if (std::sscanf(argv[++i], "%f,%f,%f,%f", &fx, &fy, &cx, &cy) != 4) {
+                std::cerr << "-c expects fx,fy,cx,cy" << std::endl;
+                return 1;
+            }
+        } else if (arg == "-j" && i + 1 < argc)
+            threads = std::atoi(argv[++i]);
+        else if (arg == "-a")
+            affinity = true;
+        else if (arg == "-p")
+            params.usePattern = true;
+        else if (arg == "-o" && i + 1 < argc)
+            outFile = argv[++i];
+        else {
+            std::cerr << "Unknown argument " << arg << std::endl;
+            return 1;
+        }
+    }
+    if (rgbDir.empty()) {
+        std::cerr << "usage: " << argv[0] << " -r rgb_dir [-d depth_dir] [-t template] [-c fx,fy,cx,cy]"
+                     " [-j threads] [-a] [-p] [-o out.csv]" << std::endl;
+        return 1;
+    }
+    threads = std::max(threads, 1);
+    TaskScheduler::init(threads - 1, affinity);
+
+    const cv::Mat templ = cv::imread(templFile);
+    if (templ.empty()) {
+        std::cerr << "Could not read " << templFile << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> rgbFiles, depthFiles;
+    if (!listDirectory(rgbDir, rgbFiles)) {
+        std::cerr << "Could not read " << rgbDir << std::endl;
+        return 1;
+    }
+    if (!depthDir.empty() && !listDirectory(depthDir, depthFiles)) {
+        std::cerr << "Could not read " << depthDir << std::endl;
+        return 1;
+    }
+
+    std::map<std::string, std::string> depthByStem;
+    for (size_t i = 0; i < depthFiles.size(); i++)
+        depthByStem[stem(depthFiles[i])] = depthDir + "/" + depthFiles[i];
+
+    std::vector<Frame> frames(rgbFiles.size());
+    for (size_t i = 0; i < rgbFiles.size(); i++) {
+        frames[i].name = rgbFiles[i];
+        frames[i].rgbFile = rgbDir + "/" + rgbFiles[i];
+        std::map<std::string, std::string>::const_iterator d = depthByStem.find(stem(rgbFiles[i]));
+        if (d != depthByStem.end())
+            frames[i].depthFile = d->second;
+    }
+
+    // rays of the size of the first frame; frames of another size get the same pinhole rays
+    // computed per box (no distortion)
+    CameraCalibration calibration(fx, fy, cx, cy);
+    if (!frames.empty()) {
+        const cv::Mat first = cv::imread(frames[0].rgbFile);
+        if (!first.empty())
+            calibration.buildRayTable(first.size());
+    }
+    ObjectPerception perception(params);
+    perception.setTemplate(templ);
+    perception.setCalibration(calibration);
+
+    std::vector<FrameResult> results(frames.size());
+    const int64 start = cv::getTickCount();
+    TaskScheduler::parallelFor(cv::Range(0, frames.size()), FrameBody(frames, results, perception));
+    const double wall = (cv::getTickCount() - start)/cv::getTickFrequency();
+
+    std::ofstream file;
+    if (!outFile.empty()) {
+        file.open(outFile.c_str());
+        if (!file) {
+            std::cerr << "Could not write " << outFile << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& out = outFile.empty() ? std::cout : file;
+
+    out << "file,found,u,v,x,y,z,yaw,plane_fit,depth_median,depth_count,pattern_found,ms" << std::endl;
+    int read = 0, found = 0;
+    for (size_t i = 0; i < frames.size(); i++) {
+        const FrameResult& fr = results[i];
+        if (!fr.read) {
+            std::cerr << "Could not read " << frames[i].rgbFile << ", skipped" << std::endl;
+            continue;
+        }
+        read++;
+        const PerceptionResult& r = fr.result;
+        found += r.found;
+        out << frames[i].name << "," << r.found << ","
+            << r.box.x + r.box.width/2 << "," << r.box.y + r.box.height/2 << ","
+            << std::fixed << std::setprecision(4)
+            << r.position.x << "," << r.position.y << "," << r.position.z << "," << r.yaw << ","
+            << r.planeFit << "," << r.depth.median << "," << r.depth.count << ","
+            << r.patternFound << "," << fr.ms << std::endl;
+        out.unsetf(std::ios::fixed);
+    }
+
+    std::cerr << read << " frames, " << found << " found, " << threads << " threads, "
+              << std::fixed << std::setprecision(2) << wall << " s ("
+              << (wall > 0 ? read/wall : 0.0) << " fps)" << std::endl;
+    std::cerr << Profiler::report();
+    TaskScheduler::shutdown();
+    return 0;
+}
@@ -0,0 +1,156 @@
+/* * * * * * * * * * * * * * * * * * * *
+ * =======  FIND OBJECT RECORD  ======= *
+ *  Log of the inputs of findObject    *
+ * =================================== *
+ * * * * * * * * * * * * * * * * * * * */
+// Records what findObject subscribes to (same parameters), the robot and camera transforms
+// at each image and the move_base goals and results, for an offline replay
+// (see the replay_file parameter of findObject).
+#include <iostream>
+#include <ros/ros.h>
+#include <image_transport/image_transport.h>
+#include <tf/transform_listener.h>
+#include <move_base_msgs/MoveBaseActionGoal.h>
+#include <move_base_msgs/MoveBaseActionResult.h>
+#include <actionlib_msgs/GoalStatus.h>
+
+#include "RosLog.hpp"
+
+class SensorRecorder{
+public:
+    SensorRecorder();
+    bool isOpen() const { return log.isOpen(); }
+
+private:
+    void readImage(const sensor_msgs::ImageConstPtr& msg);
+    void readDepth(const sensor_msgs::ImageConstPtr& msg);
+    void readKam(const sensor_msgs::CameraInfoConstPtr& msg);
+    void mapper(const nav_msgs::OccupancyGridConstPtr& msg);
+    void mapUpdater(const map_msgs::OccupancyGridUpdateConstPtr& msg);
+    void goalSent(const move_base_msgs::MoveBaseActionGoalConstPtr& msg);
+    void goalResult(const move_base_msgs::MoveBaseActionResultConstPtr& msg);
+    void recordTransform(const std::string& parent, const std::string& child);
+
+    ros::NodeHandle nh_;
+    image_transport::ImageTransport it;
+    image_transport::Subscriber ima_sub_;
+    image_transport::Subscriber dep_sub_;
+    ros::Subscriber cam_info_;
+    ros::Subscriber mapSub;
+    ros::Subscriber mapUpdSub;
+    ros::Subscriber goalSub;
+    ros::Subscriber resultSub;
+    tf::TransformListener listener;
+    std::string fixed_frame;
+    std::string base_frame;
+    std::string camera_frame;
+    LogWriter log;
+    LogRecord record;
+    int frames;
+};
+
+SensorRecorder::SensorRecorder() : it(nh_), frames(0){
+    std::string depth_node_name, rgb_node_name, caminfo_node_name, record_file;
+    int chunkSize;
+    nh_.param<std::string>("/findObject/robot_frame_name", fixed_frame, "/map");
+    nh_.param<std::string>("/findObject/base_frame_name", base_frame, "/base_link");
+    nh_.param<std::string>("/findObject/camera_frame_name", camera_frame, "/camera_link");
+    nh_.param<std::string>("/findObject/depth_node_name", depth_node_name, "/camera/depth/image_raw");
+    nh_.param<std::string>("/findObject/rgb_node_name", rgb_node_name, "/camera/rgb/image_raw");
+    nh_.param<std::string>("/findObject/caminfo_node_name", caminfo_node_name, "/camera/rgb/camera_info");
+    nh_.param<std::string>("/findObject/record_file", record_file, "findObject.log");
+    nh_.param<int>("/findObject/record_chunk_size", chunkSize, 4<<20);
+
+    if (!log.open(record_file, chunkSize)){
+        ROS_ERROR("Could not open %s", record_file.c_str());
+        return;
+    }
+    ROS_INFO("Recording to %s", record_file.c_str());
+
+    ima_sub_ = it.subscribe(rgb_node_name, 1, &SensorRecorder::readImage, this);
+    dep_sub_ = it.subscribe(depth_node_name, 1, &SensorRecorder::readDepth, this);
+    cam_info_ = nh_.subscribe(caminfo_node_name, 1, &SensorRecorder::readKam, this);
+    mapSub = nh_.subscribe("/map", 10, &SensorRecorder::mapper, this);
+    mapUpdSub = nh_.subscribe("/map_updates", 10, &SensorRecorder::mapUpdater, this);
+    goalSub = nh_.subscribe("/move_base/goal", 10, &SensorRecorder::goalSent, this);
+    resultSub = nh_.subscribe("/move_base/result", 10, &SensorRecorder::goalResult, this);
+}
+
+void SensorRecorder::recordTransform(const std::string& parent, const std::string& child){
+    try{
+        tf::StampedTransform transform;
+        listener.lookupTransform(parent, child, ros::Time(0), transform);
+        transformToRecord(transform, record);
+        log.write(record);
+    }catch (tf::TransformException &ex){
+        // not available yet, the replay will miss it as the node did
+    }
+}
+
+void SensorRecorder::readImage(const sensor_msgs::ImageConstPtr& msg){
+    // the transforms the node looks up while it processes this frame
+    recordTransform(fixed_frame, base_frame);
+    recordTransform(base_frame, camera_frame);
+
+    imageToRecord(msg, LOG_RGB, record);
+    log.write(record);
+    if (++frames % 300 == 0)
+        ROS_INFO("%d frames recorded", frames);
+}
+
+void SensorRecorder::readDepth(const sensor_msgs::ImageConstPtr& msg){
+    imageToRecord(msg, LOG_DEPTH, record);
+    log.write(record);
+}
+
+void SensorRecorder::readKam(const sensor_msgs::CameraInfoConstPtr& msg){
+    cameraInfoToRecord(*msg, record);
+    log.write(record);
+}
+
+void SensorRecorder::mapper(const nav_msgs::OccupancyGridConstPtr& msg){
+    mapToRecord(*msg, record);
+    log.write(record);
+}
+
+void SensorRecorder::mapUpdater(const map_msgs::OccupancyGridUpdateConstPtr& msg){
+    mapUpdateToRecord(*msg, record);
+    log.write(record);
+}
+
+void SensorRecorder::goalSent(const move_base_msgs::MoveBaseActionGoalConstPtr& msg){
+    record = LogRecord();
+    record.type = LOG_GOAL_SENT;
+    record.stamp = msg->header.stamp.toSec();
+    record.frame = msg->goal_id.id;
+    log.write(record);
+}
+
+void SensorRecorder::goalResult(const move_base_msgs::MoveBaseActionResultConstPtr& msg){
+    // same mapping as the SimpleActionClient
+    actionlib::SimpleClientGoalState::StateEnum state;
+    switch (msg->status.status){
+    case actionlib_msgs::GoalStatus::SUCCEEDED: state = actionlib::SimpleClientGoalState::SUCCEEDED; break;
+    case actionlib_msgs::GoalStatus::ABORTED:   state = actionlib::SimpleClientGoalState::ABORTED; break;
+    case actionlib_msgs::GoalStatus::PREEMPTED: state = actionlib::SimpleClientGoalState::PREEMPTED; break;
+    case actionlib_msgs::GoalStatus::REJECTED:  state = actionlib::SimpleClientGoalState::REJECTED; break;
+    case actionlib_msgs::GoalStatus::RECALLED:  state = actionlib::SimpleClientGoalState::RECALLED; break;
+    default:                                    state = actionlib::SimpleClientGoalState::LOST; break;
+    }
+
+    record = LogRecord();
+    record.type = LOG_GOAL_RESULT;
+    record.stamp = msg->header.stamp.toSec();
+    record.frame = msg->status.goal_id.id;
+    record.values.push_back(state);
+    log.write(record);
+}
+
+int main(int argc, char** argv){
+    ros::init(argc, argv, "findObject_record");
+    SensorRecorder recorder;
+    if (!recorder.isOpen())
+        return 1;
+    ros::spin();
+    return 0;
+}
@@ -21,6 +21,7 @@ CameraCalibration::CameraCalibration()
 CameraCalibration::CameraCalibration(float _fx, float _fy, float _cx, float _cy)
 {
     m_intrinsic = cv::Matx33f::zeros();
+    m_intrinsic(2,2) = 1;
 
     fx() = _fx;
     fy() = _fy;
@@ -35,6 +36,7 @@ CameraCalibration::CameraCalibration(float _fx, float _fy, float _cx, float _cy)
 CameraCalibration::CameraCalibration(float _fx, float _fy, float _cx, float _cy, float distorsionCoeff[5])
 {
     m_intrinsic = cv::Matx33f::zeros();
+    m_intrinsic(2,2) = 1;
 
     fx() = _fx;
     fy() = _fy;
@@ -58,12 +60,12 @@ const cv::Mat_<float>&  CameraCalibration::getDistorsion() const
 
 float& CameraCalibration::fx()
 {
-    return m_intrinsic(1,1);
+    return m_intrinsic(0,0);
 }
 
 float& CameraCalibration::fy()
 {
-    return m_intrinsic(0,0);
+    return m_intrinsic(1,1);
 }
 
 float& CameraCalibration::cx()
@@ -78,12 +80,12 @@ float& CameraCalibration::cy()
 
 float CameraCalibration::fx() const
 {
-    return m_intrinsic(1,1);
+    return m_intrinsic(0,0);
 }
 
 float CameraCalibration::fy() const
 {
-    return m_intrinsic(0,0);
+    return m_intrinsic(1,1);
 }
 
 float CameraCalibration::cx() const
@@ -94,4 +96,57 @@ float CameraCalibration::cx() const
 float CameraCalibration::cy() const
 {
     return m_intrinsic(1,2);
-}
\ No newline at end of file
+}
+
+void CameraCalibration::buildRayTable(cv::Size imageSize, bool undistort)
+{
+    m_rays.create(imageSize);
+
+    if (!undistort)
+    {
+        const float ifx = 1.f / fx();
+        const float ify = 1.f / fy();
+        for (int v = 0; v < imageSize.height; v++)
+        {
+            cv::Vec2f* row = m_rays[v];
+            const float y = (v - cy()) * ify;
+            for (int u = 0; u < imageSize.width; u++)
+                row[u] = cv::Vec2f((u - cx()) * ifx, y);
+        }
+        return;
+    }
+
+    // Undistort the pixel grid all at once to normalized coordinates
+    cv::Mat_<cv::Vec2f> pixels(1, imageSize.area());
+    for (int v = 0; v < imageSize.height; v++)
+        for (int u = 0; u < imageSize.width; u++)
+            pixels(0, v*imageSize.width + u) = cv::Vec2f(u, v);
+
+    cv::Mat normalized;
+    cv::undistortPoints(pixels, normalized, cv::Mat(m_intrinsic), m_distortion);
+    normalized.reshape(2, imageSize.height).copyTo(m_rays);
+}
+
+bool CameraCalibration::hasRayTable() const
+{
+    return !m_rays.empty();
+}
+
+const cv::Mat_<cv::Vec2f>& CameraCalibration::getRayTable() const
+{
+    return m_rays;
+}
+
+cv::Mat_<cv::Vec2f> CameraCalibration::getRays(const cv::Rect& roi) const
+{
+    if ((roi & cv::Rect(0, 0, m_rays.cols, m_rays.rows)) == roi)
+        return m_rays(roi);
+
+    cv::Mat_<cv::Vec2f> rays(roi.size());
+    const float ifx = 1.f / fx();
+    const float ify = 1.f / fy();
+    for (int i = 0; i < roi.height; i++)
+        for (int j = 0; j < roi.width; j++)
+            rays(i,j) = cv::Vec2f((roi.x + j - cx()) * ifx, (roi.y + i - cy()) * ify);
+    return rays;
+}
@@ -43,9 +43,26 @@ public:
 
     float cx() const;
     float cy() const;
+
+    /**
+    * Build the table of the rays (x/z, y/z) of every pixel of an image of size @imageSize.
+    * If @undistort is set the rays are corrected with the distortion coefficients.
+    * The table only has to be rebuilt when the calibration or the image size changes.
+    */
+    void buildRayTable(cv::Size imageSize, bool undistort = false);
+    bool hasRayTable() const;
+    const cv::Mat_<cv::Vec2f>& getRayTable() const;
+
+    /**
+    * Rays of the pixels of the image region @roi: a view of the ray table when it covers it,
+    * otherwise computed from the pinhole model without distortion.
+    */
+    cv::Mat_<cv::Vec2f> getRays(const cv::Rect& roi) const;
+
 private:
     cv::Matx33f     m_intrinsic;
     cv::Mat_<float> m_distortion;
+    cv::Mat_<cv::Vec2f> m_rays;
 };
 
 #endif
@@ -0,0 +1,116 @@
+////////////////////////////////////////////////////////////////////
+// File includes:
+#include "ClearanceMap.hpp"
+
+////////////////////////////////////////////////////////////////////
+// Standard includes:
+#include <cmath>
+#include <algorithm>
+
+ClearanceMap::ClearanceMap()
+: maxDistance(50)
+{
+}
+
+void ClearanceMap::setMap(const cv::Mat& map)
+{
+    CV_Assert(map.type() == CV_8UC1);
+    m_dist.create(map.size(), CV_32F);
+
+    const cv::Rect all(0, 0, map.cols, map.rows);
+    compute(map, all, all);
+}
+
+void ClearanceMap::update(const cv::Mat& map, const cv::Rect& dirty)
+{
+    if (m_dist.size() != map.size()) {
+        setMap(map);
+        return;
+    }
+
+    const cv::Rect all(0, 0, map.cols, map.rows);
+    const cv::Rect changed = dirty & all;
+    if (changed.area() == 0)
+        return;
+
+    // capped distances of the cells closer than maxDistance to the change may differ, and
+    // they only depend on the obstacles closer than maxDistance to them
+    const int margin = std::ceil(maxDistance) + 1;
+    const cv::Rect target = cv::Rect(changed.x - margin, changed.y - margin,
+                                     changed.width + 2*margin, changed.height + 2*margin) & all;
+    const cv::Rect window = cv::Rect(target.x - margin, target.y - margin,
+                                     target.width + 2*margin, target.height + 2*margin) & all;
+    compute(map, window, target);
+}
+
+void ClearanceMap::compute(const cv::Mat& map, const cv::Rect& window, const cv::Rect& target)
+{
+    cv::Mat notOccupied = (map(window) != MAP_OCCUPIED);
+    cv::Mat dist;
+    cv::distanceTransform(notOccupied, dist, CV_DIST_L2, CV_DIST_MASK_PRECISE);
+    cv::min(dist, maxDistance, dist);
+
+    dist(target - window.tl()).copyTo(m_dist(target));
+}
+
+bool ClearanceMap::empty() const
+{
+    return m_dist.empty();
+}
+
+float ClearanceMap::clearance(cv::Point cell) const
+{
+    if (!cv::Rect(0, 0, m_dist.cols, m_dist.rows).contains(cell))
+        return 0;
+    return m_dist.at<float>(cell);
+}
+
+bool ClearanceMap::isValid(const cv::Mat& map, cv::Point cell, float minClearance) const
+{
+    return cv::Rect(0, 0, map.cols, map.rows).contains(cell) && map.at<uchar>(cell) == MAP_FREE
+        && clearance(cell) >= minClearance;
+}
+
+bool ClearanceMap::lineOfSight(const cv::Mat& map, cv::Point from, cv::Point to) const
+{
+    cv::LineIterator it(map, from, to, 8);
+    // the last cells are the object itself, which may be marked occupied
+    for (int i = 0; i < it.count - 2; i++, ++it)
+        if (**it == MAP_OCCUPIED)
+            return false;
+    return true;
+}
+
+void ClearanceMap::findApproachPoses(const cv::Mat& map, cv::Point2f object, double side, float radius,
+                                     float minClearance, std::vector<ApproachPose>& poses, int samples) const
+{
+    poses.clear();
+    if (empty() || samples <= 0)
+        return;
+
+    const cv::Point objectCell(cvRound(object.x), cvRound(object.y));
+    const double step = 2*M_PI/samples;
+    // 0, +step, -step, +2*step, ... : closest to the preferred side first
+    for (int k = 0; k < samples; k++) {
+        const int offset = (k + 1)/2;
+        const double deviation = (k % 2 ? 1 : -1)*offset*step;
+        const double angle = side + deviation;
+
+        const cv::Point cell(cvRound(object.x + radius*std::cos(angle)),
+                             cvRound(object.y + radius*std::sin(angle)));
+        if (!isValid(map, cell, minClearance) || !lineOfSight(map, cell, objectCell))
+            continue;
+
+        ApproachPose pose;
+        pose.cell = cell;
+        pose.yaw = std::atan2(object.y - cell.y, object.x - cell.x);
+        pose.clearance = clearance(cell);
+        pose.deviation = std::fabs(deviation);
+        poses.push_back(pose);
+    }
+}
+
+const cv::Mat& ClearanceMap::getDistance() const
+{
+    return m_dist;
+}
@@ -0,0 +1,80 @@
+#ifndef CLEARANCEMAP_HPP
+#define CLEARANCEMAP_HPP
+
+////////////////////////////////////////////////////////////////////
+// File includes:
+#include "OccupancyMap.hpp"
+
+#include <opencv2/opencv.hpp>
+
+#include <vector>
+
+/**
+ * Candidate pose to look at an object from, in map cells.
+ */
+struct ApproachPose
+{
+    cv::Point cell;
+    double    yaw;          // heading towards the object
+    float     clearance;    // cells to the closest obstacle
+    double    deviation;    // angle (rad) away from the preferred side of the ring
+};
+
+/**
+ * Cached distance transform of the obstacles of the 8 bits map (see OccupancyMap.hpp).
+ * Distances are in cells and capped at maxDistance, so that a change of the map only
+ * affects the cells closer than maxDistance to it: update() recomputes that neighbourhood only.
+ * Cells are (x = column, y = row).
+ */
+class ClearanceMap
+{
+public:
+    ClearanceMap();
+
+    /**
+     * Full recomputation.
+     */
+    void setMap(const cv::Mat& map);
+
+    /**
+     * Recompute the distances after the @dirty part of @map changed.
+     * Falls back to setMap() when the map size changed.
+     */
+    void update(const cv::Mat& map, const cv::Rect& dirty);
+
+    bool empty() const;
+
+    /**
+     * Distance (cells) of @cell to the closest obstacle, 0 outside of the map.
+     */
+    float clearance(cv::Point cell) const;
+
+    /**
+     * True if @cell is free and at least @minClearance cells away from obstacles.
+     */
+    bool isValid(const cv::Mat& map, cv::Point cell, float minClearance) const;
+
+    /**
+     * Valid poses on the ring of @radius cells around @object, the ones closest to the preferred
+     * angle @side (direction from the object to the pose) first. A pose is kept when it is valid,
+     * and the segment to the object does not cross an occupied cell.
+     * The ring is sampled every 2*pi/@samples.
+     */
+    void findApproachPoses(const cv::Mat& map, cv::Point2f object, double side, float radius,
+                           float minClearance, std::vector<ApproachPose>& poses, int samples = 32) const;
+
+    /**
+     * CV_32F distances.
+     */
+    const cv::Mat& getDistance() const;
+
+    float maxDistance;  // cells
+
+private:
+    void compute(const cv::Mat& map, const cv::Rect& window, const cv::Rect& target);
+    bool lineOfSight(const cv::Mat& map, cv::Point from, cv::Point to) const;
+
+    cv::Mat m_dist;
+};
+
+#endif
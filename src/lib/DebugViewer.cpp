@@ -0,0 +1,136 @@
+////////////////////////////////////////////////////////////////////
+// File includes:
+#include "DebugViewer.hpp"
+#include "Tracer.hpp"
+
+#include <cv_bridge/cv_bridge.h>
+#include <sensor_msgs/image_encodings.h>
+
+////////////////////////////////////////////////////////////////////
+// Standard includes:
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/resource.h>
+
+DebugViewer::DebugViewer()
+: m_period(0.2)
+, m_display(true)
+, m_scale(1.0)
+, m_running(false)
+{
+}
+
+DebugViewer::~DebugViewer()
+{
+    stop();
+}
+
+int DebugViewer::addView(const std::string& window)
+{
+    View view;
+    view.window = window;
+    view.hasPublisher = false;
+    m_views.push_back(view);
+    return int(m_views.size()) - 1;
+}
+
+int DebugViewer::addView(const std::string& window, const image_transport::Publisher& publisher)
+{
+    const int idx = addView(window);
+    m_views[idx].publisher = publisher;
+    m_views[idx].hasPublisher = true;
+    return idx;
+}
+
+void DebugViewer::start(double rate, bool display, double scale)
+{
+    stop();
+    if (rate <= 0)
+        return;
+    m_period = 1.0/rate;
+    m_display = display;
+    m_scale = scale > 0 ? scale : 1.0;
+    m_running = true;
+    m_thread = boost::thread(&DebugViewer::run, this);
+}
+
+void DebugViewer::stop()
+{
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        if (!m_running)
+            return;
+        m_running = false;
+    }
+    m_stopped.notify_all();
+    m_thread.join();
+}
+
+bool DebugViewer::wants(int view) const
+{
+    if (!m_running)
+        return false;
+    const View& v = m_views[view];
+    return (m_display && !v.window.empty()) || (v.hasPublisher && v.publisher.getNumSubscribers() > 0);
+}
+
+void DebugViewer::post(int view, const cv::Mat& image, const ros::Time& stamp)
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_views[view].image = image;
+    m_views[view].stamp = stamp;
+}
+
+void DebugViewer::show(View& view, const cv::Mat& image, const ros::Time& stamp)
+{
+    cv::Mat scaled = image;
+    if (m_scale != 1.0)
+        cv::resize(image, scaled, cv::Size(), m_scale, m_scale, m_scale < 1.0 ? cv::INTER_AREA : cv::INTER_LINEAR);
+
+    if (m_display && !view.window.empty())
+        cv::imshow(view.window, scaled);
+
+    if (view.hasPublisher && view.publisher.getNumSubscribers() > 0) {
+        cv_bridge::CvImage frame;
+        frame.header.stamp = stamp;
+        frame.encoding = sensor_msgs::image_encodings::BGR8;
+        frame.image = scaled;
+        view.publisher.publish(frame.toImageMsg());
+    }
+}
+
+void DebugViewer::run()
+{
+    // lowest useful priority: the control loop goes first (Linux nices threads individually)
+    setpriority(PRIO_PROCESS, int(syscall(SYS_gettid)), 10);
+
+    std::vector<cv::Mat> images(m_views.size());
+    std::vector<ros::Time> stamps(m_views.size());
+    boost::mutex::scoped_lock lock(m_mutex);
+    while (m_running) {
+        const boost::system_time deadline = boost::get_system_time()
+            + boost::posix_time::microseconds(long(m_period*1e6));
+        while (m_running && m_stopped.timed_wait(lock, deadline)) {}
+        if (!m_running)
+            break;
+
+        // take the pending images, show them without holding the lock
+        for (size_t i = 0; i < m_views.size(); i++) {
+            images[i] = m_views[i].image;
+            stamps[i] = m_views[i].stamp;
+            m_views[i].image.release();
+        }
+        lock.unlock();
+        {
+            TRACE_SCOPE("debugViewer");
+            for (size_t i = 0; i < m_views.size(); i++)
+                if (!images[i].empty())
+                    show(m_views[i], images[i], stamps[i]);
+            if (m_display)
+                cv::waitKey(1); // HighGUI event processing
+            for (size_t i = 0; i < images.size(); i++)
+                images[i].release();
+        }
+        lock.lock();
+    }
+}
@@ -0,0 +1,77 @@
+#ifndef DEBUGVIEWER_HPP
+#define DEBUGVIEWER_HPP
+
+////////////////////////////////////////////////////////////////////
+// File includes:
+#include <ros/ros.h>
+#include <image_transport/image_transport.h>
+#include <opencv2/opencv.hpp>
+
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+#include <string>
+#include <vector>
+
+/**
+ * Debug images of the node, shown and published by a low priority thread at a fixed rate,
+ * so the control loop never waits on the GUI or on the image encoding.
+ * Each view is a window and/or an image topic. Only the latest image posted to a view is
+ * kept; it is published only while the topic has subscribers.
+ * The HighGUI calls are all made from the viewer thread.
+ */
+class DebugViewer
+{
+public:
+    DebugViewer();
+    ~DebugViewer();
+
+    /**
+     * Add a view before start(). @window is the name of its window, empty for none;
+     * @publisher is optional.
+     */
+    int addView(const std::string& window);
+    int addView(const std::string& window, const image_transport::Publisher& publisher);
+
+    /**
+     * @rate in Hz; @display false for headless runs (topics only); the images are
+     * resized by @scale before they are shown or published.
+     */
+    void start(double rate, bool display, double scale);
+    void stop();
+
+    /**
+     * Whether an image posted now to @view would be used: skip drawing it otherwise.
+     */
+    bool wants(int view) const;
+
+    /**
+     * Hand over a BGR image. It is not copied: the caller must not draw on it afterwards.
+     */
+    void post(int view, const cv::Mat& image, const ros::Time& stamp);
+
+private:
+    struct View
+    {
+        std::string                window;
+        image_transport::Publisher publisher;
+        bool                       hasPublisher;
+        cv::Mat                    image;     // latest posted, not shown yet
+        ros::Time                  stamp;
+    };
+
+    void run();
+    void show(View& view, const cv::Mat& image, const ros::Time& stamp);
+
+    std::vector<View>         m_views;
+    double                    m_period;   // seconds
+    bool                      m_display;
+    double                    m_scale;
+    bool                      m_running;
+    mutable boost::mutex      m_mutex;
+    boost::condition_variable m_stopped;
+    boost::thread             m_thread;
+};
+
+#endif
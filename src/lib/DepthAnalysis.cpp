@@ -0,0 +1,251 @@
+////////////////////////////////////////////////////////////////////
+// File includes:
+#include "DepthAnalysis.hpp"
+
+////////////////////////////////////////////////////////////////////
+// Standard includes:
+#include <cmath>
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+    // Weighted sums of the normal equations of Z = slope*X + intercept
+    struct LineSums
+    {
+        double n, x, z, xx, xz, zz;
+        LineSums() : n(0), x(0), z(0), xx(0), xz(0), zz(0) {}
+    };
+
+    // x/z of a pixel column from the pinhole model: (j+px-u0)/alpha_x
+    struct PinholeRays
+    {
+        double a0, invAlpha;
+        void setRow(int) {}
+        double operator[](int j) const { return a0 + j*invAlpha; }
+    };
+
+    // x/z of a pixel column read from a precomputed ray table
+    struct TableRays
+    {
+        const cv::Mat_<cv::Vec2f>* table;
+        const cv::Vec2f* row;
+        void setRow(int i) { row = (*table)[i]; }
+        double operator[](int j) const { return row[j][0]; }
+    };
+
+    /**
+     * One pass over the region. Without model (huberK<=0) every valid pixel weights 1,
+     * otherwise the weights are Huber weights of the residuals to (slope, intercept).
+     * The inner loop is branch free so the compiler can vectorize it.
+     */
+    template <typename T, typename Rays>
+    void accumulateLine(const cv::Mat& depth, const cv::Mat& mask, Rays rays,
+                        double slope, double intercept, double huberK, LineSums& s)
+    {
+        const bool robust = huberK > 0;
+        for (int i = 0; i < depth.rows; i++) {
+            const T* zrow = depth.ptr<T>(i);
+            const uchar* mrow = mask.empty() ? 0 : mask.ptr<uchar>(i);
+            rays.setRow(i);
+
+            double n=0, sx=0, sz=0, sxx=0, sxz=0, szz=0;
+            for (int j = 0; j < depth.cols; j++) {
+                const T zraw = zrow[j];
+                const bool use = isValidDepth(zraw) && (mrow == 0 || mrow[j] != 0);
+                const double z = use ? double(zraw) : 0.0;
+                const double x = rays[j]*z;
+
+                double w = use ? 1.0 : 0.0;
+                if (robust) {
+                    const double r = std::fabs(z - (slope*x + intercept));
+                    w = (r <= huberK) ? w : w*huberK/r;
+                }
+
+                n   += w;
+                sx  += w*x;
+                sz  += w*z;
+                sxx += w*x*x;
+                sxz += w*x*z;
+                szz += w*z*z;
+            }
+            s.n += n; s.x += sx; s.z += sz;
+            s.xx += sxx; s.xz += sxz; s.zz += szz;
+        }
+    }
+
+    /**
+     * Solve the normal equations. Also returns the weighted residual standard deviation.
+     */
+    bool solveLine(const LineSums& s, double& slope, double& intercept, double& sigma)
+    {
+        if (s.n < 2)
+            return false;
+
+        const double det = s.n*s.xx - s.x*s.x;
+        if (!(det > 1e-12*s.n*s.xx))
+            return false;
+
+        slope = (s.n*s.xz - s.x*s.z)/det;
+        intercept = (s.z - slope*s.x)/s.n;
+
+        const double rss = s.zz - slope*s.xz - intercept*s.z;
+        sigma = rss > 0 ? std::sqrt(rss/s.n) : 0.0;
+        return true;
+    }
+
+    template <typename T, typename Rays>
+    bool fitLine(const cv::Mat& depth, const cv::Mat& mask, const Rays& rays,
+                 DepthLineFit& fit, DepthFitMode mode, int irlsIterations)
+    {
+        double slope=0, intercept=0, sigma=0;
+
+        LineSums s;
+        accumulateLine<T>(depth, mask, rays, 0, 0, 0, s);
+        if (!solveLine(s, slope, intercept, sigma))
+            return false;
+
+        if (mode == DEPTH_FIT_IRLS) {
+            for (int it = 0; it < irlsIterations && sigma > 0; it++) {
+                // 95% efficiency constant of the Huber estimator
+                const double k = 1.345*sigma;
+
+                LineSums ws;
+                accumulateLine<T>(depth, mask, rays, slope, intercept, k, ws);
+
+                double wslope, wintercept, wsigma;
+                if (!solveLine(ws, wslope, wintercept, wsigma))
+                    break;
+                slope = wslope;
+                intercept = wintercept;
+                sigma = wsigma;
+                s = ws;
+            }
+        }
+
+        fit.slope = slope;
+        fit.intercept = intercept;
+        fit.weight = s.n;
+        fit.valid = true;
+        return true;
+    }
+
+    template <typename Rays>
+    bool fitLineDispatch(const cv::Mat& depth, const cv::Mat& mask, const Rays& rays,
+                         DepthLineFit& fit, DepthFitMode mode, int irlsIterations)
+    {
+        fit.slope = 0;
+        fit.intercept = 0;
+        fit.weight = 0;
+        fit.valid = false;
+
+        if (depth.empty())
+            return false;
+        CV_Assert(mask.empty() || (mask.type() == CV_8UC1 && mask.size() == depth.size()));
+
+        switch (depth.type()) {
+        case CV_16UC1:
+            return fitLine<unsigned short>(depth, mask, rays, fit, mode, irlsIterations);
+        case CV_32FC1:
+            return fitLine<float>(depth, mask, rays, fit, mode, irlsIterations);
+        default:
+            CV_Error(CV_StsUnsupportedFormat, "fitDepthLine: depth must be CV_16UC1 or CV_32FC1");
+        }
+        return false;
+    }
+
+    template <typename T>
+    void depthStats(const cv::Mat& depth, double depthScale, double minDepth, double maxDepth,
+                    cv::Mat& mask, DepthStats& stats)
+    {
+        std::vector<float> values;
+        values.reserve(depth.total());
+
+        double sum = 0;
+        for (int i = 0; i < depth.rows; i++) {
+            const T* zrow = depth.ptr<T>(i);
+            uchar* mrow = mask.ptr<uchar>(i);
+            for (int j = 0; j < depth.cols; j++) {
+                const double z = double(zrow[j])*depthScale;
+                const bool valid = isValidDepth(zrow[j]) && z >= minDepth && z <= maxDepth;
+                mrow[j] = valid ? 255 : 0;
+                if (valid) {
+                    sum += z;
+                    values.push_back(float(z));
+                }
+            }
+        }
+
+        stats.count = int(values.size());
+        if (values.empty())
+            return;
+
+        stats.mean = sum/values.size();
+        std::vector<float>::iterator mid = values.begin() + values.size()/2;
+        std::nth_element(values.begin(), mid, values.end());
+        stats.median = *mid;
+    }
+}
+
+bool fitDepthLine(const cv::Mat& depth, const cv::Mat& mask, double alpha_x, double u0, double px,
+                  DepthLineFit& fit, DepthFitMode mode, int irlsIterations)
+{
+    if (alpha_x == 0) {
+        fit.valid = false;
+        return false;
+    }
+
+    // X = (j+px-u0)*z/alpha_x = (a0 + j*invAlpha)*z
+    PinholeRays rays;
+    rays.invAlpha = 1.0/alpha_x;
+    rays.a0 = (px - u0)*rays.invAlpha;
+    return fitLineDispatch(depth, mask, rays, fit, mode, irlsIterations);
+}
+
+bool fitDepthLine(const cv::Mat& depth, const cv::Mat& mask, const CameraCalibration& calibration,
+                  cv::Point offset, DepthLineFit& fit, DepthFitMode mode, int irlsIterations)
+{
+    const cv::Mat_<cv::Vec2f> table = calibration.getRays(cv::Rect(offset, depth.size()));
+
+    TableRays rays;
+    rays.table = &table;
+    rays.row = 0;
+    return fitLineDispatch(depth, mask, rays, fit, mode, irlsIterations);
+}
+
+double defaultDepthScale(int depthType)
+{
+    switch (depthType) {
+    case CV_16UC1:
+        return 0.001;
+    case CV_32FC1:
+        return 1.0;
+    default:
+        CV_Error(CV_StsUnsupportedFormat, "defaultDepthScale: depth must be CV_16UC1 or CV_32FC1");
+    }
+    return 1.0;
+}
+
+bool computeDepthStats(const cv::Mat& depth, double depthScale, cv::Mat& mask, DepthStats& stats,
+                       double minDepth, double maxDepth)
+{
+    stats.mean = 0;
+    stats.median = 0;
+    stats.count = 0;
+
+    mask.create(depth.size(), CV_8UC1);
+    if (depth.empty())
+        return false;
+
+    switch (depth.type()) {
+    case CV_16UC1:
+        depthStats<unsigned short>(depth, depthScale, minDepth, maxDepth, mask, stats);
+        break;
+    case CV_32FC1:
+        depthStats<float>(depth, depthScale, minDepth, maxDepth, mask, stats);
+        break;
+    default:
+        CV_Error(CV_StsUnsupportedFormat, "computeDepthStats: depth must be CV_16UC1 or CV_32FC1");
+    }
+    return stats.count > 0;
+}
@@ -0,0 +1,73 @@
+#ifndef DEPTHANALYSIS_HPP
+#define DEPTHANALYSIS_HPP
+
+////////////////////////////////////////////////////////////////////
+// File includes:
+#include "CameraCalibration.hpp"
+#include "DepthValue.hpp"
+
+#include <opencv2/opencv.hpp>
+
+/**
+ * Line Z = slope*X + intercept fitted to the back-projected pixels of a depth region.
+ * X and Z are in the native units of the depth image.
+ */
+struct DepthLineFit
+{
+    double slope;
+    double intercept;
+    double weight;  // number of points used (sum of weights in robust mode)
+    bool   valid;
+};
+
+enum DepthFitMode
+{
+    DEPTH_FIT_LEAST_SQUARES,
+    DEPTH_FIT_IRLS          // least squares re-weighted with Huber weights, for noisy edges
+};
+
+/**
+ * Fit a line to the X-Z profile of a masked depth region, X = (u-u0)*Z/alpha_x.
+ * @depth is a CV_16UC1 or CV_32FC1 ROI whose top-left corner is at column @px of the image,
+ * @mask is a CV_8UC1 mask of the same size (empty means every pixel).
+ * Zero and non-finite depths are ignored. The 2x2 normal equations are accumulated
+ * directly in one pass (one more per IRLS iteration) and nothing is allocated.
+ * Returns false (and fit.valid=false) when there are less than two points or they are degenerate.
+ */
+bool fitDepthLine(const cv::Mat& depth, const cv::Mat& mask, double alpha_x, double u0, double px,
+                  DepthLineFit& fit, DepthFitMode mode = DEPTH_FIT_LEAST_SQUARES, int irlsIterations = 3);
+
+/**
+ * Same as above, with X = x_ray*Z taken from the ray table of @calibration
+ * (see CameraCalibration::buildRayTable). @offset is the top-left corner of @depth in the image.
+ */
+bool fitDepthLine(const cv::Mat& depth, const cv::Mat& mask, const CameraCalibration& calibration,
+                  cv::Point offset, DepthLineFit& fit,
+                  DepthFitMode mode = DEPTH_FIT_LEAST_SQUARES, int irlsIterations = 3);
+
+/**
+ * Statistics of the valid readings of a depth region, in meters.
+ */
+struct DepthStats
+{
+    double mean;
+    double median;
+    int    count;   // number of valid pixels
+};
+
+/**
+ * Meters per depth unit of the usual depth encodings:
+ * 0.001 for CV_16UC1 (millimeters), 1 for CV_32FC1 (meters).
+ */
+double defaultDepthScale(int depthType);
+
+/**
+ * Compute the validity mask and the statistics of a raw CV_16UC1 or CV_32FC1 depth ROI.
+ * @depthScale converts the depth values to meters. A reading is valid when it is non zero,
+ * finite and within [@minDepth, @maxDepth] meters. @mask gets 255 on valid pixels.
+ * Returns false when there is no valid reading.
+ */
+bool computeDepthStats(const cv::Mat& depth, double depthScale, cv::Mat& mask, DepthStats& stats,
+                       double minDepth = 0, double maxDepth = DBL_MAX);
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef DEPTHVALUE_HPP
+#define DEPTHVALUE_HPP
+
+////////////////////////////////////////////////////////////////////
+// Standard includes:
+#include <cfloat>
+
+/**
+ * Depth readings that carry no measurement: zero (and NaN/inf for float images).
+ */
+inline bool isValidDepth(unsigned short z) { return z != 0; }
+inline bool isValidDepth(float z) { return z > 0 && z < FLT_MAX; } // false for NaN
+
+#endif
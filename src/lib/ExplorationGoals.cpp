@@ -0,0 +1,70 @@
+////////////////////////////////////////////////////////////////////
+// File includes:
+#include "ExplorationGoals.hpp"
+
+////////////////////////////////////////////////////////////////////
+// Standard includes:
+#include <algorithm>
+
+void selectExplorationGoals(const cv::Mat& map, const FrontierPlanner& frontiers, const GridPlanner& planner,
+                            cv::Point start, cv::Point home, const std::vector<cv::Point>& viewpoints,
+                            size_t count, cv::RNG& rng, ExplorationGoals& goals)
+{
+    goals.revisits.clear();
+    goals.frontiers.clear();
+    goals.samples.clear();
+    goals.path.clear();
+
+    // the places the object was most likely seen from are visited before exploring
+    const cv::Rect mapRect(0, 0, map.cols, map.rows);
+    for (size_t i = 0; i < viewpoints.size(); i++) {
+        const cv::Point v = viewpoints[i];
+        if (mapRect.contains(v) && map.at<uchar>(v.y, v.x) == MAP_FREE)
+            goals.revisits.push_back(v);
+    }
+    size_t candidates = 1 + goals.revisits.size();
+
+    // best frontiers first, ranked by information gain versus path cost from the robot
+    std::vector<FrontierCluster> clusters;
+    frontiers.rank(map, start, clusters);
+    for (size_t i = 0; i < clusters.size() && candidates < count + 1; i++, candidates++)
+        goals.frontiers.push_back(clusters[i].goal);
+
+    // nothing left to explore: sample free points around home
+    for (int attempts = 0; candidates < count + 1 && attempts < 1000; attempts++) {
+        const int px = home.x - 10.0 + rng.uniform(0.0, 1.0)*20;
+        const int py = home.y - 10.0 + rng.uniform(0.0, 1.0)*20;
+        const cv::Point p(px, py);
+        if (mapRect.contains(p) && map.at<uchar>(p.y, p.x) == MAP_FREE) {
+            goals.samples.push_back(p);
+            candidates++;
+        }
+    }
+
+    // keep the reachable points only, visiting the closest first
+    std::vector<cv::Point> revisit(1, home);
+    revisit.insert(revisit.end(), goals.revisits.begin(), goals.revisits.end());
+    std::vector<cv::Point> explore(goals.frontiers);
+    explore.insert(explore.end(), goals.samples.begin(), goals.samples.end());
+    std::vector<cv::Point> all(revisit);
+    all.insert(all.end(), explore.begin(), explore.end());
+    planner.filterGoals(start, revisit);
+    planner.filterGoals(revisit.empty() ? start : revisit.back(), explore);
+    goals.path = revisit;
+    goals.path.insert(goals.path.end(), explore.begin(), explore.end());
+    if (!goals.path.empty())
+        return;
+
+    // none of them can be reached: go as close as the free space of the robot allows
+    // (the explore state would skip the candidates themselves as unreachable)
+    cv::Point robot;
+    const int label = planner.nearestTraversable(start, planner.snapRadius, robot) ? planner.component(robot) : 0;
+    for (size_t i = 0; i < all.size(); i++) {
+        cv::Point q = all[i];
+        if (label != 0 && !planner.nearestInComponent(all[i], label, q))
+            continue;
+        // without a free robot cell the reachability check cannot tell and keeps the candidates
+        if (std::find(goals.path.begin(), goals.path.end(), q) == goals.path.end())
+            goals.path.push_back(q);
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef EXPLORATIONGOALS_HPP
+#define EXPLORATIONGOALS_HPP
+
+////////////////////////////////////////////////////////////////////
+// File includes:
+#include "OccupancyMap.hpp"
+#include "FrontierPlanner.hpp"
+#include "GridPlanner.hpp"
+
+#include <opencv2/opencv.hpp>
+
+#include <vector>
+
+/**
+ * Goals of one exploration round, in map cells (x = column, y = row).
+ */
+struct ExplorationGoals
+{
+    std::vector<cv::Point> revisits;    // viewpoints of past sightings on free cells
+    std::vector<cv::Point> frontiers;   // best ranked frontier goals
+    std::vector<cv::Point> samples;     // free cells drawn around home when frontiers run out
+    std::vector<cv::Point> path;        // goals to visit, in order
+};
+
+/**
+ * Candidates: @home, the @viewpoints on free cells, then the best frontiers ranked from
+ * @start and, when there are not enough of them, free cells drawn with @rng within 10 cells
+ * of @home, @count goals besides @home at most.
+ * The path keeps the candidates @planner can reach, the revisits (@home first) then the
+ * others, each part as a nearest-next tour. When none can be reached, it gets the closest
+ * cells of the component of @start instead, or the candidates themselves if @start is not
+ * in free space.
+ */
+void selectExplorationGoals(const cv::Mat& map, const FrontierPlanner& frontiers, const GridPlanner& planner,
+                            cv::Point start, cv::Point home, const std::vector<cv::Point>& viewpoints,
+                            size_t count, cv::RNG& rng, ExplorationGoals& goals);
+
+#endif
@@ -0,0 +1,196 @@
+////////////////////////////////////////////////////////////////////
+// File includes:
+#include "FrontierPlanner.hpp"
+
+////////////////////////////////////////////////////////////////////
+// Standard includes:
+#include <cmath>
+#include <queue>
+#include <functional>
+#include <algorithm>
+
+namespace
+{
+    const int NEIGHBORS = 8;
+    const int DX[NEIGHBORS] = { 1, -1, 0, 0, 1, 1, -1, -1 };
+    const int DY[NEIGHBORS] = { 0, 0, 1, -1, 1, -1, 1, -1 };
+    const float STEP[NEIGHBORS] = { 1, 1, 1, 1, 1.41421356f, 1.41421356f, 1.41421356f, 1.41421356f };
+
+    typedef std::pair<float, int> QueueItem; // cost, linear index
+
+    bool betterScore(const FrontierCluster& a, const FrontierCluster& b)
+    {
+        return a.score > b.score;
+    }
+
+    /**
+     * Frontier cells of map(context), written into @frontier (of the size of the context).
+     * A frontier cell is a free cell with an unknown 4-neighbor.
+     */
+    void computeFrontier(const cv::Mat& map, const cv::Rect& context, cv::Mat& frontier)
+    {
+        const cv::Mat m = map(context);
+        cv::Mat unknown = (m == MAP_UNKNOWN);
+        cv::Mat cross = cv::getStructuringElement(cv::MORPH_CROSS, cv::Size(3,3));
+        cv::dilate(unknown, unknown, cross);
+
+        cv::bitwise_and(m == MAP_FREE, unknown, frontier);
+    }
+}
+
+FrontierPlanner::FrontierPlanner()
+: minClusterSize(5)
+, gainRadius(10)
+, costWeight(0.02)
+{
+}
+
+void FrontierPlanner::update(const cv::Mat& map, const cv::Rect& dirty)
+{
+    CV_Assert(map.type() == CV_8UC1);
+    const cv::Rect all(0, 0, map.cols, map.rows);
+
+    if (m_frontier.size() != map.size()) {
+        computeFrontier(map, all, m_frontier);
+        return;
+    }
+
+    if (dirty.area() == 0)
+        return;
+
+    // changed cells and their neighbors may change status; their neighbors are needed as context
+    const cv::Rect region = cv::Rect(dirty.x-1, dirty.y-1, dirty.width+2, dirty.height+2) & all;
+    const cv::Rect context = cv::Rect(region.x-1, region.y-1, region.width+2, region.height+2) & all;
+
+    cv::Mat local;
+    computeFrontier(map, context, local);
+    local(region - context.tl()).copyTo(m_frontier(region));
+}
+
+const cv::Mat& FrontierPlanner::getFrontierMask() const
+{
+    return m_frontier;
+}
+
+void FrontierPlanner::computeCostMap(const cv::Mat& map, cv::Point start, cv::Mat& cost)
+{
+    cost.create(map.size(), CV_32F);
+    cost.setTo(-1);
+    if (!cv::Rect(0, 0, map.cols, map.rows).contains(start))
+        return;
+
+    // Dijkstra over free cells (the start cell is accepted whatever its value)
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem> > open;
+    cost.at<float>(start) = 0;
+    open.push(QueueItem(0.f, start.y*map.cols + start.x));
+
+    while (!open.empty()) {
+        const QueueItem item = open.top();
+        open.pop();
+        const int x = item.second % map.cols;
+        const int y = item.second / map.cols;
+        if (item.first > cost.at<float>(y,x))
+            continue;
+
+        for (int k = 0; k < NEIGHBORS; k++) {
+            const int nx = x + DX[k], ny = y + DY[k];
+            if (nx < 0 || ny < 0 || nx >= map.cols || ny >= map.rows)
+                continue;
+            if (map.at<uchar>(ny,nx) != MAP_FREE)
+                continue;
+
+            const float c = item.first + STEP[k];
+            float& nc = cost.at<float>(ny,nx);
+            if (nc < 0 || c < nc) {
+                nc = c;
+                open.push(QueueItem(c, ny*map.cols + nx));
+            }
+        }
+    }
+}
+
+void FrontierPlanner::rank(const cv::Mat& map, cv::Point start, std::vector<FrontierCluster>& clusters) const
+{
+    clusters.clear();
+    if (m_frontier.empty() || m_frontier.size() != map.size())
+        return;
+
+    cv::Mat cost;
+    computeCostMap(map, start, cost);
+
+    // integral image of the unknown cells: O(1) information gain per cluster
+    cv::Mat unknown = (map == MAP_UNKNOWN)/MAP_FREE;
+    cv::Mat unknownSum;
+    cv::integral(unknown, unknownSum, CV_32S);
+
+    cv::Mat visited = cv::Mat::zeros(map.size(), CV_8U);
+    std::vector<cv::Point> cells;
+    std::vector<cv::Point> stack;
+
+    for (int y = 0; y < map.rows; y++) {
+        const uchar* frow = m_frontier.ptr<uchar>(y);
+        for (int x = 0; x < map.cols; x++) {
+            if (!frow[x] || visited.at<uchar>(y,x))
+                continue;
+
+            // flood fill the 8-connected cluster
+            cells.clear();
+            stack.clear();
+            stack.push_back(cv::Point(x,y));
+            visited.at<uchar>(y,x) = 1;
+            while (!stack.empty()) {
+                const cv::Point c = stack.back();
+                stack.pop_back();
+                cells.push_back(c);
+                for (int k = 0; k < NEIGHBORS; k++) {
+                    const int nx = c.x + DX[k], ny = c.y + DY[k];
+                    if (nx < 0 || ny < 0 || nx >= map.cols || ny >= map.rows)
+                        continue;
+                    if (!m_frontier.at<uchar>(ny,nx) || visited.at<uchar>(ny,nx))
+                        continue;
+                    visited.at<uchar>(ny,nx) = 1;
+                    stack.push_back(cv::Point(nx,ny));
+                }
+            }
+
+            if ((int)cells.size() < minClusterSize)
+                continue;
+
+            FrontierCluster cluster;
+            cluster.size = cells.size();
+            cv::Point2f sum(0,0);
+            for (size_t i = 0; i < cells.size(); i++)
+                sum += cv::Point2f(cells[i].x, cells[i].y);
+            cluster.centroid = sum * (1.f/cells.size());
+
+            // the goal is the reachable cell of the cluster closest to the centroid
+            float bestDist = -1;
+            for (size_t i = 0; i < cells.size(); i++) {
+                if (cost.at<float>(cells[i]) < 0)
+                    continue;
+                const float dx = cells[i].x - cluster.centroid.x;
+                const float dy = cells[i].y - cluster.centroid.y;
+                const float d = dx*dx + dy*dy;
+                if (bestDist < 0 || d < bestDist) {
+                    bestDist = d;
+                    cluster.goal = cells[i];
+                }
+            }
+            if (bestDist < 0)
+                continue; // unreachable cluster
+
+            const cv::Rect window = cv::Rect(cluster.goal.x - gainRadius, cluster.goal.y - gainRadius,
+                                             2*gainRadius + 1, 2*gainRadius + 1)
+                                    & cv::Rect(0, 0, map.cols, map.rows);
+            cluster.gain = unknownSum.at<int>(window.br())
+                         - unknownSum.at<int>(window.y, window.x + window.width)
+                         - unknownSum.at<int>(window.y + window.height, window.x)
+                         + unknownSum.at<int>(window.tl());
+            cluster.cost = cost.at<float>(cluster.goal);
+            cluster.score = cluster.gain * std::exp(-costWeight*cluster.cost);
+            clusters.push_back(cluster);
+        }
+    }
+
+    std::sort(clusters.begin(), clusters.end(), betterScore);
+}
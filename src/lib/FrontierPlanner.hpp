@@ -0,0 +1,64 @@
+#ifndef FRONTIERPLANNER_HPP
+#define FRONTIERPLANNER_HPP
+
+////////////////////////////////////////////////////////////////////
+// File includes:
+#include "OccupancyMap.hpp"
+
+#include <opencv2/opencv.hpp>
+
+#include <vector>
+
+/**
+ * Group of connected frontier cells, candidate exploration goal.
+ * Coordinates are map cells (x = column, y = row).
+ */
+struct FrontierCluster
+{
+    cv::Point   goal;       // frontier cell of the cluster closest to its centroid
+    cv::Point2f centroid;
+    int         size;       // number of frontier cells
+    int         gain;       // unknown cells around the goal
+    double      cost;       // path length from the start, in cells
+    double      score;
+};
+
+/**
+ * Exploration planner based on frontiers: free cells next to unknown cells of the map
+ * (see OccupancyMap.hpp for the cell values).
+ * The frontier mask is maintained incrementally from the changed parts of the map.
+ */
+class FrontierPlanner
+{
+public:
+    FrontierPlanner();
+
+    /**
+     * Update the frontier cells affected by a change of @map inside @dirty.
+     * Everything is recomputed when the map size changes.
+     */
+    void update(const cv::Mat& map, const cv::Rect& dirty);
+
+    /**
+     * Cluster the frontier cells and rank the clusters reachable from @start by
+     * information gain versus path cost: score = gain * exp(-costWeight * cost).
+     * Clusters are returned best first.
+     */
+    void rank(const cv::Mat& map, cv::Point start, std::vector<FrontierCluster>& clusters) const;
+
+    const cv::Mat& getFrontierMask() const;
+
+    /**
+     * Path length (in cells, 8-connected) from @start to every free cell, -1 where unreachable.
+     */
+    static void computeCostMap(const cv::Mat& map, cv::Point start, cv::Mat& cost);
+
+    int    minClusterSize;  // smaller clusters are ignored (sensor noise)
+    int    gainRadius;      // half size of the window where unknown cells are counted
+    double costWeight;
+
+private:
+    cv::Mat m_frontier;
+};
+
+#endif
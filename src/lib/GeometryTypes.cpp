@@ -2,6 +2,10 @@
 // File includes:
 #include "GeometryTypes.hpp"
 
+////////////////////////////////////////////////////////////////////
+// Standard includes:
+#include <cmath>
+
 Transformation::Transformation()
 : m_rotation(Matx33f::eye())
 , m_translation(Vec3f(0,0,0))
@@ -55,7 +59,104 @@ Matx44f Transformation::getMat44() const
   return res;
 }
 
+Transformation Transformation::fromQuaternion(const Vec4f& q, const Vec3f& t)
+{
+  const float n = std::sqrt(q.dot(q));
+  const float x = q[0]/n, y = q[1]/n, z = q[2]/n, w = q[3]/n;
+
+  const Matx33f r(1 - 2*(y*y + z*z), 2*(x*y - z*w),     2*(x*z + y*w),
+                  2*(x*y + z*w),     1 - 2*(x*x + z*z), 2*(y*z - x*w),
+                  2*(x*z - y*w),     2*(y*z + x*w),     1 - 2*(x*x + y*y));
+  return Transformation(r, t);
+}
+
 Transformation Transformation::getInverted() const
 {
-    return Transformation(m_rotation.t(), -m_translation);
+  const Matx33f rt = m_rotation.t();
+  return Transformation(rt, -(rt*m_translation));
+}
+
+Vec4f Transformation::getQuaternion() const
+{
+  const Matx33f& m = m_rotation;
+  const float trace = m(0,0) + m(1,1) + m(2,2);
+  Vec4f q;
+
+  // largest of w, x, y, z first for numerical stability
+  if (trace > 0)
+  {
+    const float s = 2*std::sqrt(1 + trace);
+    q = Vec4f((m(2,1) - m(1,2))/s, (m(0,2) - m(2,0))/s, (m(1,0) - m(0,1))/s, s/4);
+  }
+  else if (m(0,0) > m(1,1) && m(0,0) > m(2,2))
+  {
+    const float s = 2*std::sqrt(1 + m(0,0) - m(1,1) - m(2,2));
+    q = Vec4f(s/4, (m(0,1) + m(1,0))/s, (m(0,2) + m(2,0))/s, (m(2,1) - m(1,2))/s);
+  }
+  else if (m(1,1) > m(2,2))
+  {
+    const float s = 2*std::sqrt(1 + m(1,1) - m(0,0) - m(2,2));
+    q = Vec4f((m(0,1) + m(1,0))/s, s/4, (m(1,2) + m(2,1))/s, (m(0,2) - m(2,0))/s);
+  }
+  else
+  {
+    const float s = 2*std::sqrt(1 + m(2,2) - m(0,0) - m(1,1));
+    q = Vec4f((m(0,2) + m(2,0))/s, (m(1,2) + m(2,1))/s, s/4, (m(1,0) - m(0,1))/s);
+  }
+
+  if (q[3] < 0)
+    q = -q;
+  return q;
+}
+
+Transformation Transformation::operator*(const Transformation& other) const
+{
+  return Transformation(m_rotation*other.m_rotation, m_rotation*other.m_translation + m_translation);
+}
+
+Point3f Transformation::operator()(const Point3f& p) const
+{
+  const Matx33f& r = m_rotation;
+  return Point3f(r(0,0)*p.x + r(0,1)*p.y + r(0,2)*p.z + m_translation[0],
+                 r(1,0)*p.x + r(1,1)*p.y + r(1,2)*p.z + m_translation[1],
+                 r(2,0)*p.x + r(2,1)*p.y + r(2,2)*p.z + m_translation[2]);
+}
+
+void Transformation::apply(const Point3f* in, size_t n, Point3f* out) const
+{
+  // coefficients in locals so that the compiler keeps them in registers and vectorizes the loop
+  const float r00 = m_rotation(0,0), r01 = m_rotation(0,1), r02 = m_rotation(0,2);
+  const float r10 = m_rotation(1,0), r11 = m_rotation(1,1), r12 = m_rotation(1,2);
+  const float r20 = m_rotation(2,0), r21 = m_rotation(2,1), r22 = m_rotation(2,2);
+  const float tx = m_translation[0], ty = m_translation[1], tz = m_translation[2];
+
+  for (size_t i = 0; i < n; i++)
+  {
+    const float x = in[i].x, y = in[i].y, z = in[i].z;
+    out[i].x = r00*x + r01*y + r02*z + tx;
+    out[i].y = r10*x + r11*y + r12*z + ty;
+    out[i].z = r20*x + r21*y + r22*z + tz;
+  }
+}
+
+void Transformation::projectPoints(const Point3f* in, size_t n, const Matx33f& K, Point2f* out) const
+{
+  const float r00 = m_rotation(0,0), r01 = m_rotation(0,1), r02 = m_rotation(0,2);
+  const float r10 = m_rotation(1,0), r11 = m_rotation(1,1), r12 = m_rotation(1,2);
+  const float r20 = m_rotation(2,0), r21 = m_rotation(2,1), r22 = m_rotation(2,2);
+  const float tx = m_translation[0], ty = m_translation[1], tz = m_translation[2];
+  const float fx = K(0,0), fy = K(1,1), cx = K(0,2), cy = K(1,2);
+
+  for (size_t i = 0; i < n; i++)
+  {
+    const float x = in[i].x, y = in[i].y, z = in[i].z;
+    const float X = r00*x + r01*y + r02*z + tx;
+    const float Y = r10*x + r11*y + r12*z + ty;
+    const float Z = r20*x + r21*y + r22*z + tz;
+
+    const bool front = Z > 0;
+    const float invZ = front ? 1.0f/Z : 0.0f;
+    out[i].x = front ? fx*X*invZ + cx : -1.0f;
+    out[i].y = front ? fy*Y*invZ + cy : -1.0f;
+  }
 }
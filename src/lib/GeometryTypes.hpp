@@ -5,10 +5,18 @@
 
 using namespace cv;
 
+/**
+ * Rigid transformation p' = R p + t
+ */
 struct Transformation
 {
   Transformation();
   Transformation(const Matx33f& r, const Vec3f& t);
+
+  /**
+   * From a unit quaternion (x, y, z, w) and a translation
+   */
+  static Transformation fromQuaternion(const Vec4f& q, const Vec3f& t);
   
   Matx33f& r();
   Vec3f&  t();
@@ -16,9 +24,38 @@ struct Transformation
   const Matx33f& r() const;
   const Vec3f&  t() const;
   
+  /**
+   * Column-major layout for OpenGL: the translation is in the last row
+   */
   Matx44f getMat44() const;
   
+  /**
+   * (R^T, -R^T t)
+   */
   Transformation getInverted() const;
+
+  /**
+   * Unit quaternion (x, y, z, w) of the rotation, with w >= 0
+   */
+  Vec4f getQuaternion() const;
+
+  /**
+   * Composition: (a*b)(p) = a(b(p))
+   */
+  Transformation operator*(const Transformation& other) const;
+
+  Point3f operator()(const Point3f& p) const;
+
+  /**
+   * Transform @n points. @out may be @in.
+   */
+  void apply(const Point3f* in, size_t n, Point3f* out) const;
+
+  /**
+   * Transform @n points and project them with a pinhole camera without distortion.
+   * Points behind the camera get (-1, -1).
+   */
+  void projectPoints(const Point3f* in, size_t n, const Matx33f& K, Point2f* out) const;
 private:
   Matx33f m_rotation;
   Vec3f  m_translation;
@@ -0,0 +1,264 @@
+////////////////////////////////////////////////////////////////////
+// File includes:
+#include "GridPlanner.hpp"
+
+////////////////////////////////////////////////////////////////////
+// Standard includes:
+#include <cmath>
+#include <queue>
+#include <functional>
+#include <algorithm>
+#include <cfloat>
+
+namespace
+{
+    const int NEIGHBORS = 8;
+    const int DX[NEIGHBORS] = { 1, -1, 0, 0, 1, 1, -1, -1 };
+    const int DY[NEIGHBORS] = { 0, 0, 1, -1, 1, -1, 1, -1 };
+    const float STEP[NEIGHBORS] = { 1, 1, 1, 1, 1.41421356f, 1.41421356f, 1.41421356f, 1.41421356f };
+
+    typedef std::pair<float, int> QueueItem; // priority, linear index
+
+    inline float octile(int dx, int dy)
+    {
+        dx = std::abs(dx);
+        dy = std::abs(dy);
+        return std::max(dx, dy) + 0.41421356f*std::min(dx, dy);
+    }
+}
+
+GridPlanner::GridPlanner()
+: robotRadius(4)
+, inflationRadius(10)
+, inflationCost(5)
+, snapRadius(5)
+{
+}
+
+void GridPlanner::setMap(const cv::Mat& map)
+{
+    ClearanceMap clearance;
+    clearance.maxDistance = std::max(inflationRadius, robotRadius) + 1;
+    clearance.setMap(map);
+    setMap(map, clearance);
+}
+
+void GridPlanner::setMap(const cv::Mat& map, const ClearanceMap& clearance)
+{
+    CV_Assert(map.type() == CV_8UC1 && clearance.getDistance().size() == map.size());
+
+    clearance.getDistance().copyTo(m_clearance);
+    buildCostmap(map);
+    labelComponents();
+}
+
+bool GridPlanner::hasMap() const
+{
+    return !m_cost.empty();
+}
+
+void GridPlanner::buildCostmap(const cv::Mat& map)
+{
+    // cost = 1 + inflationCost*(inflationRadius - clearance)/(inflationRadius - robotRadius), clamped to [1, 1+inflationCost]
+    const float span = std::max(inflationRadius - robotRadius, 1e-3f);
+    cv::Mat penalty = (inflationRadius - m_clearance)*(inflationCost/span);
+    cv::threshold(penalty, penalty, 0, 0, cv::THRESH_TOZERO);
+    cv::min(penalty, inflationCost, penalty);
+    m_cost = penalty + 1;
+
+    m_cost.setTo(-1, m_clearance < robotRadius);
+    // unknown cells are not traversable
+    m_cost.setTo(-1, map != MAP_FREE);
+}
+
+void GridPlanner::labelComponents()
+{
+    m_labels = cv::Mat::zeros(m_cost.size(), CV_32S);
+
+    int label = 0;
+    std::vector<int> stack;
+    for (int y = 0; y < m_cost.rows; y++) {
+        for (int x = 0; x < m_cost.cols; x++) {
+            if (m_cost.at<float>(y,x) < 0 || m_labels.at<int>(y,x) != 0)
+                continue;
+
+            label++;
+            m_labels.at<int>(y,x) = label;
+            stack.push_back(y*m_cost.cols + x);
+            while (!stack.empty()) {
+                const int idx = stack.back();
+                stack.pop_back();
+                const int cx = idx % m_cost.cols, cy = idx / m_cost.cols;
+                for (int k = 0; k < NEIGHBORS; k++) {
+                    const int nx = cx + DX[k], ny = cy + DY[k];
+                    if (nx < 0 || ny < 0 || nx >= m_cost.cols || ny >= m_cost.rows)
+                        continue;
+                    if (m_cost.at<float>(ny,nx) < 0 || m_labels.at<int>(ny,nx) != 0)
+                        continue;
+                    m_labels.at<int>(ny,nx) = label;
+                    stack.push_back(ny*m_cost.cols + nx);
+                }
+            }
+        }
+    }
+}
+
+bool GridPlanner::isTraversable(cv::Point cell) const
+{
+    return cv::Rect(0, 0, m_cost.cols, m_cost.rows).contains(cell) && m_cost.at<float>(cell) >= 0;
+}
+
+bool GridPlanner::nearestTraversable(cv::Point cell, int radius, cv::Point& out) const
+{
+    int bestDist = -1;
+    for (int dy = -radius; dy <= radius; dy++) {
+        for (int dx = -radius; dx <= radius; dx++) {
+            const cv::Point c(cell.x + dx, cell.y + dy);
+            const int d = dx*dx + dy*dy;
+            if (d > radius*radius || !isTraversable(c))
+                continue;
+            if (bestDist < 0 || d < bestDist) {
+                bestDist = d;
+                out = c;
+            }
+        }
+    }
+    return bestDist >= 0;
+}
+
+int GridPlanner::component(cv::Point cell) const
+{
+    if (!cv::Rect(0, 0, m_labels.cols, m_labels.rows).contains(cell))
+        return 0;
+    return m_labels.at<int>(cell);
+}
+
+bool GridPlanner::sameComponent(cv::Point a, cv::Point b) const
+{
+    const int la = component(a);
+    return la != 0 && la == component(b);
+}
+
+bool GridPlanner::nearestInComponent(cv::Point cell, int label, cv::Point& out) const
+{
+    if (label == 0)
+        return false;
+    long bestDist = -1;
+    for (int y = 0; y < m_labels.rows; y++) {
+        const int* row = m_labels.ptr<int>(y);
+        for (int x = 0; x < m_labels.cols; x++) {
+            if (row[x] != label)
+                continue;
+            const long d = long(x - cell.x)*(x - cell.x) + long(y - cell.y)*(y - cell.y);
+            if (bestDist < 0 || d < bestDist) {
+                bestDist = d;
+                out = cv::Point(x, y);
+            }
+        }
+    }
+    return bestDist >= 0;
+}
+
+double GridPlanner::findPath(cv::Point start, cv::Point goal, std::vector<cv::Point>* path) const
+{
+    if (path)
+        path->clear();
+    if (!hasMap())
+        return -1;
+
+    // the robot may stand in the inflated zone, and goals may be next to walls
+    if (!nearestTraversable(start, snapRadius, start) || !nearestTraversable(goal, snapRadius, goal))
+        return -1;
+    if (!sameComponent(start, goal))
+        return -1;
+
+    const int cols = m_cost.cols;
+    cv::Mat g(m_cost.size(), CV_32F, cv::Scalar(FLT_MAX));
+    cv::Mat parent;
+    if (path)
+        parent = cv::Mat(m_cost.size(), CV_32S, cv::Scalar(-1));
+
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem> > open;
+    g.at<float>(start) = 0;
+    open.push(QueueItem(octile(goal.x - start.x, goal.y - start.y), start.y*cols + start.x));
+
+    const int goalIdx = goal.y*cols + goal.x;
+    while (!open.empty()) {
+        const QueueItem item = open.top();
+        open.pop();
+        const int idx = item.second;
+        if (idx == goalIdx)
+            break;
+
+        const int x = idx % cols, y = idx / cols;
+        const float gc = g.at<float>(y,x);
+        if (item.first - octile(goal.x - x, goal.y - y) > gc + 1e-4f)
+            continue; // stale entry
+
+        for (int k = 0; k < NEIGHBORS; k++) {
+            const int nx = x + DX[k], ny = y + DY[k];
+            if (nx < 0 || ny < 0 || nx >= cols || ny >= m_cost.rows)
+                continue;
+            const float c = m_cost.at<float>(ny,nx);
+            if (c < 0)
+                continue;
+
+            const float ng = gc + STEP[k]*c;
+            float& old = g.at<float>(ny,nx);
+            if (ng < old) {
+                old = ng;
+                if (path)
+                    parent.at<int>(ny,nx) = idx;
+                open.push(QueueItem(ng + octile(goal.x - nx, goal.y - ny), ny*cols + nx));
+            }
+        }
+    }
+
+    const float cost = g.at<float>(goal);
+    if (cost == FLT_MAX)
+        return -1;
+
+    if (path) {
+        for (int idx = goalIdx; idx >= 0; idx = parent.at<int>(idx / cols, idx % cols))
+            path->push_back(cv::Point(idx % cols, idx / cols));
+        std::reverse(path->begin(), path->end());
+    }
+    return cost;
+}
+
+void GridPlanner::filterGoals(cv::Point start, std::vector<cv::Point>& goals) const
+{
+    std::vector<cv::Point> remaining;
+    for (size_t i = 0; i < goals.size(); i++) {
+        cv::Point s, g;
+        if (nearestTraversable(start, snapRadius, s) && nearestTraversable(goals[i], snapRadius, g)
+            && sameComponent(s, g))
+            remaining.push_back(goals[i]);
+    }
+
+    // greedy tour: always go to the cheapest remaining goal
+    goals.clear();
+    cv::Point current = start;
+    while (!remaining.empty()) {
+        int bestIdx = -1;
+        double bestCost = 0;
+        for (size_t i = 0; i < remaining.size(); i++) {
+            const double c = findPath(current, remaining[i]);
+            if (c >= 0 && (bestIdx < 0 || c < bestCost)) {
+                bestIdx = i;
+                bestCost = c;
+            }
+        }
+        if (bestIdx < 0)
+            break;
+
+        current = remaining[bestIdx];
+        goals.push_back(current);
+        remaining.erase(remaining.begin() + bestIdx);
+    }
+}
+
+const cv::Mat& GridPlanner::getClearance() const
+{
+    return m_clearance;
+}
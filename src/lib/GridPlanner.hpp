@@ -0,0 +1,87 @@
+#ifndef GRIDPLANNER_HPP
+#define GRIDPLANNER_HPP
+
+////////////////////////////////////////////////////////////////////
+// File includes:
+#include "OccupancyMap.hpp"
+#include "ClearanceMap.hpp"
+
+#include <opencv2/opencv.hpp>
+
+#include <vector>
+
+/**
+ * In-process planner on the 8 bits map, used to reject and order goals before
+ * they are sent to move_base.
+ * Free cells farther than robotRadius from any obstacle are traversable; the cost of a cell
+ * grows when it gets closer to obstacles (inflated costmap built from a distance transform).
+ * Traversable space is labeled in connected components, so that reachability is O(1).
+ * Cells are (x = column, y = row).
+ */
+class GridPlanner
+{
+public:
+    GridPlanner();
+
+    /**
+     * Rebuild clearance, costmap and components from @map.
+     */
+    void setMap(const cv::Mat& map);
+
+    /**
+     * Same, reusing the distances of a ClearanceMap kept up to date by the caller.
+     * Its maxDistance must not be smaller than inflationRadius.
+     */
+    void setMap(const cv::Mat& map, const ClearanceMap& clearance);
+    bool hasMap() const;
+
+    bool isTraversable(cv::Point cell) const;
+
+    /**
+     * Closest traversable cell within @radius cells of @cell (the cell itself if traversable).
+     */
+    bool nearestTraversable(cv::Point cell, int radius, cv::Point& out) const;
+
+    /**
+     * Component label of a cell, 0 if not traversable.
+     */
+    int component(cv::Point cell) const;
+    bool sameComponent(cv::Point a, cv::Point b) const;
+
+    /**
+     * Closest cell of component @label to @cell (straight-line distance, scans the map).
+     */
+    bool nearestInComponent(cv::Point cell, int label, cv::Point& out) const;
+
+    /**
+     * A* search (8-connected, octile heuristic) on the costmap.
+     * Returns the path cost or -1 if @goal cannot be reached. @path gets the cells from start to goal.
+     */
+    double findPath(cv::Point start, cv::Point goal, std::vector<cv::Point>* path = 0) const;
+
+    /**
+     * Drop the goals that are not reachable from @start and reorder the rest as a
+     * greedy nearest-next tour starting at @start, using the path costs.
+     */
+    void filterGoals(cv::Point start, std::vector<cv::Point>& goals) const;
+
+    /**
+     * Distance (cells) of every cell to the closest obstacle, capped as in ClearanceMap.
+     */
+    const cv::Mat& getClearance() const;
+
+    float robotRadius;      // cells
+    float inflationRadius;  // cells, obstacles raise the cost up to this distance
+    float inflationCost;    // extra cost of a step right at robotRadius from an obstacle
+    int   snapRadius;       // start/goal cells are moved this far at most to reach traversable space
+
+private:
+    void buildCostmap(const cv::Mat& map);
+    void labelComponents();
+
+    cv::Mat m_clearance;    // CV_32F
+    cv::Mat m_cost;         // CV_32F, cost of entering a cell, <0 if not traversable
+    cv::Mat m_labels;       // CV_32S
+};
+
+#endif
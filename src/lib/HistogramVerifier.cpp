@@ -0,0 +1,95 @@
+////////////////////////////////////////////////////////////////////
+// File includes:
+#include "HistogramVerifier.hpp"
+#include "TaskScheduler.hpp"
+
+////////////////////////////////////////////////////////////////////
+// Standard includes:
+#include <cfloat>
+
+namespace
+{
+    class CandidateScore : public cv::ParallelLoopBody {
+        const cv::Mat& hsv;
+        const cv::MatND& templHist;
+        const std::vector<cv::Rect>& boxes;
+        std::vector<float>& distances;
+
+    public:
+        CandidateScore(const cv::Mat& hsv, const cv::MatND& templHist,
+                       const std::vector<cv::Rect>& boxes, std::vector<float>& distances)
+            : hsv(hsv), templHist(templHist), boxes(boxes), distances(distances) {}
+
+        void operator() (const cv::Range& range) const {
+            const cv::Rect frameRect(0, 0, hsv.cols, hsv.rows);
+            for (int i = range.start; i != range.end; i++) {
+                cv::Rect r = boxes[i] & frameRect;
+                if (r.area() == 0) {
+                    distances[i] = FLT_MAX;
+                    continue;
+                }
+
+                // ROI view, no copy of the frame
+                cv::Mat roi(hsv, r);
+                cv::MatND hist;
+                HistogramVerifier::computeHistogram(roi, hist);
+                distances[i] = (float)cv::compareHist(templHist, hist, CV_COMP_CHISQR);
+            }
+        }
+    };
+}
+
+HistogramVerifier::HistogramVerifier()
+{
+}
+
+void HistogramVerifier::setTemplate(const cv::Mat& templBgr)
+{
+    m_templHist.release();
+    if (templBgr.empty())
+        return;
+
+    cv::Mat hsv;
+    cv::cvtColor(templBgr, hsv, CV_BGR2HSV);
+    computeHistogram(hsv, m_templHist);
+}
+
+bool HistogramVerifier::hasTemplate() const
+{
+    return !m_templHist.empty();
+}
+
+void HistogramVerifier::score(const cv::Mat& frameBgr, const std::vector<cv::Rect>& boxes,
+                              std::vector<float>& distances) const
+{
+    distances.assign(boxes.size(), FLT_MAX);
+    if (boxes.empty() || frameBgr.empty())
+        return;
+
+    cv::Mat hsv;
+    cv::cvtColor(frameBgr, hsv, CV_BGR2HSV);
+    scoreHSV(hsv, boxes, distances);
+}
+
+void HistogramVerifier::scoreHSV(const cv::Mat& frameHsv, const std::vector<cv::Rect>& boxes,
+                                 std::vector<float>& distances) const
+{
+    distances.assign(boxes.size(), FLT_MAX);
+    if (boxes.empty() || frameHsv.empty() || !hasTemplate())
+        return;
+
+    TaskScheduler::parallelFor(cv::Range(0, boxes.size()),
+                               CandidateScore(frameHsv, m_templHist, boxes, distances));
+}
+
+void HistogramVerifier::computeHistogram(const cv::Mat& hsv, cv::MatND& hist)
+{
+    int h_bins = 30; int s_bins = 30;
+    int histSize[] = { h_bins, s_bins };
+    float h_ranges[] = { 0, 256 }, s_ranges[] = { 0, 180 };
+    const float* ranges[] = { h_ranges, s_ranges };
+    int channels[] = { 0, 1 };
+
+    cv::calcHist( &hsv, 1, channels, cv::Mat(), hist, 2, histSize, ranges, true, false );
+    cv::normalize( hist, hist, 0, 1, cv::NORM_MINMAX, -1, cv::Mat() );
+}
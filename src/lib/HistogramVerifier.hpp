@@ -0,0 +1,47 @@
+#ifndef HISTOGRAMVERIFIER_HPP
+#define HISTOGRAMVERIFIER_HPP
+
+////////////////////////////////////////////////////////////////////
+// File includes:
+#include <opencv2/opencv.hpp>
+
+#include <vector>
+
+/**
+ * Compares candidate regions of a frame against a template image using
+ * normalized Hue-Saturation histograms (chi-square distance).
+ * The template histogram is computed only once, in setTemplate().
+ */
+class HistogramVerifier
+{
+public:
+    HistogramVerifier();
+
+    /**
+     * Build the reference histogram from a BGR template image.
+     */
+    void setTemplate(const cv::Mat& templBgr);
+    bool hasTemplate() const;
+
+    /**
+     * Compute the distance between the template and every box of the BGR @frame.
+     * The frame is converted to HSV once and the histograms are computed on ROI views of it,
+     * all the candidates being evaluated in parallel. Empty boxes get FLT_MAX.
+     */
+    void score(const cv::Mat& frameBgr, const std::vector<cv::Rect>& boxes, std::vector<float>& distances) const;
+
+    /**
+     * Same as above, for a frame that is already in HSV.
+     */
+    void scoreHSV(const cv::Mat& frameHsv, const std::vector<cv::Rect>& boxes, std::vector<float>& distances) const;
+
+    /**
+     * Normalized 2D histogram of the first two channels of an HSV image.
+     */
+    static void computeHistogram(const cv::Mat& hsv, cv::MatND& hist);
+
+private:
+    cv::MatND m_templHist;
+};
+
+#endif
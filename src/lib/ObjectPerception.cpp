@@ -0,0 +1,156 @@
+////////////////////////////////////////////////////////////////////
+// File includes:
+#include "ObjectPerception.hpp"
+#include "Profiler.hpp"
+
+////////////////////////////////////////////////////////////////////
+// Standard includes:
+#include <cmath>
+
+PerceptionParams::PerceptionParams()
+: depthScale(0)
+, minDepth(0.3)
+, maxDepth(10.0)
+, planeMode(PLANE_FIT_PCA)
+, yawRobust(false)
+, usePattern(false)
+{
+}
+
+PerceptionResult::PerceptionResult()
+: found(false)
+, depth()
+, planeFit(false)
+, position(0, 0, 0)
+, normal(0, 0, -1)
+, yaw(0)
+, patternFound(false)
+{
+}
+
+ObjectPerception::ObjectPerception(const PerceptionParams& params)
+: params(params)
+, m_hasPattern(false)
+{
+}
+
+void ObjectPerception::setTemplate(const cv::Mat& templBgr)
+{
+    m_verifier.setTemplate(templBgr);
+    m_hasPattern = false;
+    // training the detector is the costly part: only when it will be used
+    if (templBgr.empty() || !params.usePattern)
+        return;
+
+    std::vector<cv::Mat> images(1, templBgr);
+    std::vector<Pattern> patterns;
+    m_detector.buildPatternsFromImages(images, patterns);
+    m_detector.train(patterns);
+    m_hasPattern = true;
+}
+
+bool ObjectPerception::hasTemplate() const
+{
+    return m_verifier.hasTemplate();
+}
+
+void ObjectPerception::setCalibration(const CameraCalibration& calibration)
+{
+    m_calibration = calibration;
+}
+
+const CameraCalibration& ObjectPerception::getCalibration() const
+{
+    return m_calibration;
+}
+
+double ObjectPerception::depthScale(int depthType) const
+{
+    return params.depthScale > 0 ? params.depthScale : defaultDepthScale(depthType);
+}
+
+bool ObjectPerception::detect(const cv::Mat& bgr, std::vector<cv::Point>& corners) const
+{
+    PROFILE_SCOPE("detectObject");
+    std::vector<std::vector<cv::Point> > squares;
+    findSquares(bgr, squares);
+    corners = selectSquare(squares, bgr, m_verifier);
+    return !corners.empty();
+}
+
+bool ObjectPerception::measure(const cv::Mat& depth, const std::vector<cv::Point>& corners,
+                               cv::Mat& roi, cv::Mat& mask, cv::Rect& box, DepthStats& stats) const
+{
+    PROFILE_SCOPE("depthStats");
+    stats.count = 0;
+    box = squareBoundingBox(corners) & cv::Rect(0, 0, depth.cols, depth.rows);
+    if (box.area() == 0)
+        return false;
+
+    // copy: the node keeps the ROI for the next frames
+    roi = depth(box).clone();
+    return computeDepthStats(roi, depthScale(roi.type()), mask, stats, params.minDepth, params.maxDepth);
+}
+
+double ObjectPerception::objectYaw(const cv::Mat& roi, const cv::Mat& mask, const cv::Rect& box) const
+{
+    PROFILE_SCOPE("objectYaw");
+    // fit Z = slope*X + b on the face of the object; yaw is the slope angle
+    DepthLineFit fit;
+    if (!fitDepthLine(roi, mask, m_calibration, box.tl(), fit,
+                      params.yawRobust ? DEPTH_FIT_IRLS : DEPTH_FIT_LEAST_SQUARES))
+        return 0.0; // not enough valid readings: assume the object faces the camera
+
+    return std::atan(fit.slope);
+}
+
+void ObjectPerception::estimatePose(const cv::Rect& box, const cv::Mat& roi, const cv::Mat& mask, float z,
+                                    PerceptionResult& result) const
+{
+    result.box = box;
+
+    // fit the plane of the object face: gives position and orientation at once
+    FacePlane face;
+    {
+        PROFILE_SCOPE("planeFit");
+        result.planeFit = fitDepthPlane(roi, mask, box.tl(), m_calibration, depthScale(roi.type()),
+                                        face, params.planeMode);
+    }
+    if (result.planeFit) {
+        result.position = face.centroid;
+        result.normal = face.normal;
+        // x axis of the camera link (-z optical) pointing into the face
+        result.yaw = std::atan2(face.normal[0], -face.normal[2]);
+        return;
+    }
+
+    // center of the box back-projected at depth z, yaw from the depth profile
+    const cv::Vec2f ray = m_calibration.getRays(cv::Rect(box.x + box.width/2, box.y + box.height/2, 1, 1))(0,0);
+    result.position = cv::Point3f(ray[0]*z, ray[1]*z, z);
+    result.normal = cv::Vec3f(0, 0, -1);
+    result.yaw = objectYaw(roi, mask, box);
+}
+
+bool ObjectPerception::process(const cv::Mat& bgr, const cv::Mat& depth, PerceptionResult& result) const
+{
+    result = PerceptionResult();
+
+    if (params.usePattern && m_hasPattern) {
+        PROFILE_SCOPE("pattern");
+        // scratch state per call: the trained detector is shared by the concurrent frames
+        PatternDetector::Workspace workspace;
+        result.patternFound = m_detector.findPattern(bgr, result.pattern, workspace);
+    }
+
+    if (!detect(bgr, result.corners) || depth.empty())
+        return false;
+
+    cv::Mat roi, mask;
+    cv::Rect box;
+    if (!measure(depth, result.corners, roi, mask, box, result.depth))
+        return false;
+
+    estimatePose(box, roi, mask, result.depth.median, result);
+    result.found = true;
+    return true;
+}
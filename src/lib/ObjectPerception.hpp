@@ -0,0 +1,114 @@
+#ifndef OBJECTPERCEPTION_HPP
+#define OBJECTPERCEPTION_HPP
+
+////////////////////////////////////////////////////////////////////
+// File includes:
+#include "CameraCalibration.hpp"
+#include "HistogramVerifier.hpp"
+#include "SquareDetector.hpp"
+#include "DepthAnalysis.hpp"
+#include "PlaneFit.hpp"
+#include "PatternDetector.hpp"
+
+#include <opencv2/opencv.hpp>
+
+#include <vector>
+
+/**
+ * Settings of the perception pipeline, the ~* parameters of the node.
+ */
+struct PerceptionParams
+{
+    PerceptionParams();
+
+    double       depthScale;    // meters per depth unit, 0 to deduce it from the depth type
+    double       minDepth;      // valid readings, meters
+    double       maxDepth;
+    PlaneFitMode planeMode;
+    bool         yawRobust;     // IRLS line fit for the yaw when there is no plane
+    bool         usePattern;    // also look for the template with the PatternDetector
+};
+
+/**
+ * What was found in one frame. Positions are in the camera optical frame (x right, y down,
+ * z forward), meters.
+ */
+struct PerceptionResult
+{
+    PerceptionResult();
+
+    bool                   found;       // square detected and measured in the depth image
+    std::vector<cv::Point> corners;     // detected square, empty if none
+    cv::Rect               box;         // its bounding box, clipped to the depth image
+    DepthStats             depth;       // of the valid readings inside the box
+    bool                   planeFit;    // position and normal come from the face plane
+    cv::Point3f            position;    // center of the face
+    cv::Vec3f              normal;      // face normal, towards the camera (plane fit only)
+    double                 yaw;         // heading of the face in the camera link frame, radians
+
+    bool                   patternFound;
+    PatternTrackingInfo    pattern;
+};
+
+/**
+ * Detection and pose of the object in RGB-D frames, without ROS: square candidates checked
+ * against the template histogram, depth statistics in the box, face plane (or depth line
+ * when the plane fit fails) and optionally the feature-based pattern detector.
+ * process() is the frame-in/result-out entry point; the steps are also exposed for the node,
+ * which runs them across several frames.
+ * Once the template and the calibration are set, every method is const and one instance
+ * (one trained pattern detector) can process several frames concurrently.
+ */
+class ObjectPerception
+{
+public:
+    explicit ObjectPerception(const PerceptionParams& params = PerceptionParams());
+
+    /**
+     * BGR image of the object face: reference histogram, and pattern when params.usePattern
+     * is set (set it before).
+     */
+    void setTemplate(const cv::Mat& templBgr);
+    bool hasTemplate() const;
+
+    void setCalibration(const CameraCalibration& calibration);
+    const CameraCalibration& getCalibration() const;
+
+    bool process(const cv::Mat& bgr, const cv::Mat& depth, PerceptionResult& result) const;
+
+    /**
+     * Square of @bgr most similar to the template, false if none.
+     */
+    bool detect(const cv::Mat& bgr, std::vector<cv::Point>& corners) const;
+
+    /**
+     * Copy the depth readings inside the box of @corners into @roi, with their validity @mask
+     * and statistics. @box gets the clipped box. False when there is no valid reading.
+     */
+    bool measure(const cv::Mat& depth, const std::vector<cv::Point>& corners,
+                 cv::Mat& roi, cv::Mat& mask, cv::Rect& box, DepthStats& stats) const;
+
+    /**
+     * Position, normal and yaw of the face from the depth @roi at @box, fills the pose fields
+     * of @result. @z is the depth used when the face plane cannot be fitted.
+     */
+    void estimatePose(const cv::Rect& box, const cv::Mat& roi, const cv::Mat& mask, float z,
+                      PerceptionResult& result) const;
+
+    /**
+     * Meters per unit of a depth image of type @depthType.
+     */
+    double depthScale(int depthType) const;
+
+    PerceptionParams params;
+
+private:
+    double objectYaw(const cv::Mat& roi, const cv::Mat& mask, const cv::Rect& box) const;
+
+    HistogramVerifier m_verifier;
+    CameraCalibration m_calibration;
+    PatternDetector   m_detector;
+    bool              m_hasPattern;
+};
+
+#endif
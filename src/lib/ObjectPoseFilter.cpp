@@ -0,0 +1,165 @@
+////////////////////////////////////////////////////////////////////
+// File includes:
+#include "ObjectPoseFilter.hpp"
+
+////////////////////////////////////////////////////////////////////
+// Standard includes:
+#include <cmath>
+#include <algorithm>
+
+namespace
+{
+    const int STATES = 8;
+    const int MEASUREMENTS = 4;
+    const int YAW = 3;
+
+    double wrapAngle(double a)
+    {
+        a = std::fmod(a + CV_PI, 2*CV_PI);
+        if (a < 0)
+            a += 2*CV_PI;
+        return a - CV_PI;
+    }
+}
+
+ObjectPoseFilter::ObjectPoseFilter()
+: accelerationNoise(0.05)
+, yawAccelerationNoise(0.1)
+, positionStd(0.05)
+, yawStd(0.15)
+, gate(13.28)   // 99%
+, maxRejections(5)
+, convergedStd(0.03)
+, convergedYawStd(0.05)
+, m_kf(STATES, MEASUREMENTS, 0, CV_64F)
+, m_stamp(0)
+, m_initialized(false)
+, m_rejections(0)
+{
+    // measurement is the first half of the state
+    m_kf.measurementMatrix = cv::Mat::zeros(MEASUREMENTS, STATES, CV_64F);
+    for (int i = 0; i < MEASUREMENTS; i++)
+        m_kf.measurementMatrix.at<double>(i,i) = 1;
+}
+
+void ObjectPoseFilter::reset()
+{
+    m_initialized = false;
+    m_rejections = 0;
+}
+
+bool ObjectPoseFilter::isInitialized() const
+{
+    return m_initialized;
+}
+
+void ObjectPoseFilter::init(double stamp, const cv::Point3f& position, double yaw)
+{
+    m_kf.statePost = (cv::Mat_<double>(STATES, 1) << position.x, position.y, position.z, wrapAngle(yaw), 0, 0, 0, 0);
+
+    // the object is expected to be static: small initial velocity uncertainty
+    const double p2 = positionStd*positionStd, y2 = yawStd*yawStd;
+    m_kf.errorCovPost = cv::Mat::diag((cv::Mat_<double>(STATES, 1) << p2, p2, p2, y2, 0.01, 0.01, 0.01, 0.01));
+
+    m_kf.measurementNoiseCov = cv::Mat::diag((cv::Mat_<double>(MEASUREMENTS, 1) << p2, p2, p2, y2));
+
+    m_stamp = stamp;
+    m_initialized = true;
+    m_rejections = 0;
+}
+
+void ObjectPoseFilter::predict(double stamp)
+{
+    const double dt = std::max(stamp - m_stamp, 0.0);
+    m_stamp = std::max(stamp, m_stamp);
+
+    m_kf.transitionMatrix = cv::Mat::eye(STATES, STATES, CV_64F);
+    m_kf.processNoiseCov = cv::Mat::zeros(STATES, STATES, CV_64F);
+    for (int i = 0; i < MEASUREMENTS; i++) {
+        m_kf.transitionMatrix.at<double>(i, i + MEASUREMENTS) = dt;
+
+        // discretized white acceleration
+        const double q = i == YAW ? yawAccelerationNoise : accelerationNoise;
+        const double q2 = q*q;
+        m_kf.processNoiseCov.at<double>(i, i) = q2*dt*dt*dt*dt/4;
+        m_kf.processNoiseCov.at<double>(i, i + MEASUREMENTS) = q2*dt*dt*dt/2;
+        m_kf.processNoiseCov.at<double>(i + MEASUREMENTS, i) = q2*dt*dt*dt/2;
+        m_kf.processNoiseCov.at<double>(i + MEASUREMENTS, i + MEASUREMENTS) = q2*dt*dt;
+    }
+
+    m_kf.predict();
+    // a rejected measurement leaves the prediction as estimate
+    m_kf.statePre.copyTo(m_kf.statePost);
+    m_kf.errorCovPre.copyTo(m_kf.errorCovPost);
+}
+
+bool ObjectPoseFilter::update(double stamp, const cv::Point3f& position, double yaw)
+{
+    if (!m_initialized) {
+        init(stamp, position, yaw);
+        return true;
+    }
+
+    predict(stamp);
+
+    // yaw measured on the same turn as the prediction
+    const double predictedYaw = m_kf.statePre.at<double>(YAW);
+    cv::Mat z = (cv::Mat_<double>(MEASUREMENTS, 1) << position.x, position.y, position.z,
+                 predictedYaw + wrapAngle(yaw - predictedYaw));
+
+    const cv::Mat& H = m_kf.measurementMatrix;
+    cv::Mat innovation = z - H*m_kf.statePre;
+    cv::Mat S = H*m_kf.errorCovPre*H.t() + m_kf.measurementNoiseCov;
+    const double d2 = cv::Mat(innovation.t()*S.inv(cv::DECOMP_CHOLESKY)*innovation).at<double>(0);
+
+    if (!(d2 <= gate)) {
+        if (++m_rejections >= maxRejections)
+            init(stamp, position, yaw);
+        return false;
+    }
+
+    m_kf.correct(z);
+    m_kf.statePost.at<double>(YAW) = wrapAngle(m_kf.statePost.at<double>(YAW));
+    m_rejections = 0;
+    return true;
+}
+
+cv::Point3f ObjectPoseFilter::getPosition() const
+{
+    if (!m_initialized)
+        return cv::Point3f(0, 0, 0);
+    return cv::Point3f(m_kf.statePost.at<double>(0), m_kf.statePost.at<double>(1), m_kf.statePost.at<double>(2));
+}
+
+double ObjectPoseFilter::getYaw() const
+{
+    return m_initialized ? m_kf.statePost.at<double>(YAW) : 0.0;
+}
+
+cv::Matx66d ObjectPoseFilter::getPoseCovariance() const
+{
+    cv::Matx66d cov = cv::Matx66d::zeros();
+    cov(3,3) = cov(4,4) = 1e6;
+    if (!m_initialized) {
+        cov(0,0) = cov(1,1) = cov(2,2) = cov(5,5) = 1e6;
+        return cov;
+    }
+
+    // state index of x, y, z and yaw; roll and pitch are 3 and 4 in the pose
+    const int poseIdx[MEASUREMENTS] = { 0, 1, 2, 5 };
+    const cv::Mat& P = m_kf.errorCovPost;
+    for (int i = 0; i < MEASUREMENTS; i++)
+        for (int j = 0; j < MEASUREMENTS; j++)
+            cov(poseIdx[i], poseIdx[j]) = P.at<double>(i,j);
+    return cov;
+}
+
+bool ObjectPoseFilter::hasConverged() const
+{
+    if (!m_initialized)
+        return false;
+    const cv::Mat& P = m_kf.errorCovPost;
+    const double c2 = convergedStd*convergedStd;
+    return P.at<double>(0,0) < c2 && P.at<double>(1,1) < c2 && P.at<double>(2,2) < c2
+        && P.at<double>(YAW,YAW) < convergedYawStd*convergedYawStd;
+}
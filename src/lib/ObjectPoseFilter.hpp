@@ -0,0 +1,62 @@
+#ifndef OBJECTPOSEFILTER_HPP
+#define OBJECTPOSEFILTER_HPP
+
+////////////////////////////////////////////////////////////////////
+// File includes:
+#include <opencv2/opencv.hpp>
+#include <opencv2/video/tracking.hpp>
+
+/**
+ * Constant velocity Kalman filter of the object position and yaw, in the fixed frame
+ * (meters, radians). State (x, y, z, yaw, vx, vy, vz, vyaw), measurement (x, y, z, yaw).
+ * Measurements are gated on their Mahalanobis distance to the prediction; after
+ * maxRejections consecutive outliers the filter restarts from the last one, as the object moved.
+ */
+class ObjectPoseFilter
+{
+public:
+    ObjectPoseFilter();
+
+    void reset();
+    bool isInitialized() const;
+
+    /**
+     * Predict to @stamp (seconds) and correct with the measurement.
+     * Returns false if the measurement was rejected by the gate.
+     */
+    bool update(double stamp, const cv::Point3f& position, double yaw);
+
+    cv::Point3f getPosition() const;
+    double getYaw() const;
+
+    /**
+     * Covariance of (x, y, z, roll, pitch, yaw), laid out as in geometry_msgs/PoseWithCovariance.
+     * Roll and pitch are not estimated and get a large variance.
+     */
+    cv::Matx66d getPoseCovariance() const;
+
+    /**
+     * True once the position and yaw standard deviations are below convergedStd and convergedYawStd.
+     */
+    bool hasConverged() const;
+
+    double accelerationNoise;   // m/s^2, white acceleration of the constant velocity model
+    double yawAccelerationNoise;// rad/s^2
+    double positionStd;         // m, measurement noise
+    double yawStd;              // rad, measurement noise
+    double gate;                // squared Mahalanobis distance, chi-square with 4 dof
+    int    maxRejections;
+    double convergedStd;        // m
+    double convergedYawStd;     // rad
+
+private:
+    void init(double stamp, const cv::Point3f& position, double yaw);
+    void predict(double stamp);
+
+    cv::KalmanFilter m_kf;
+    double m_stamp;
+    bool   m_initialized;
+    int    m_rejections;
+};
+
+#endif
@@ -0,0 +1,228 @@
+////////////////////////////////////////////////////////////////////
+// File includes:
+#include "ObservationMemory.hpp"
+
+////////////////////////////////////////////////////////////////////
+// Standard includes:
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+
+namespace
+{
+    struct MoreLikely
+    {
+        const std::vector<double>& scores;
+        MoreLikely(const std::vector<double>& scores) : scores(scores) {}
+        bool operator()(size_t a, size_t b) const { return scores[a] > scores[b]; }
+    };
+
+    inline float distance2(cv::Point2f a, cv::Point2f b)
+    {
+        const cv::Point2f d = a - b;
+        return d.x*d.x + d.y*d.y;
+    }
+}
+
+ObservationMemory::ObservationMemory()
+: cellSize(0.5f)
+, mergeDistance(0.25f)
+, decayTime(600)
+, m_size(0)
+{
+}
+
+int64 ObservationMemory::key(int cx, int cy) const
+{
+    return (int64(cx) << 32) | int64(unsigned(cy));
+}
+
+void ObservationMemory::cellOf(cv::Point2f position, int& cx, int& cy) const
+{
+    cx = cvFloor(position.x/cellSize);
+    cy = cvFloor(position.y/cellSize);
+}
+
+double ObservationMemory::likelihood(const Observation& observation, double now) const
+{
+    const double age = std::max(now - observation.stamp, 0.0);
+    return observation.confidence*std::exp(-age/decayTime);
+}
+
+void ObservationMemory::add(const Observation& observation)
+{
+    Grid::iterator bucket = m_grid.end();
+    size_t closest = 0;
+    int cx, cy;
+    cellOf(observation.position, cx, cy);
+    if (mergeDistance > 0) {
+        // mergeDistance <= cellSize: the neighbouring buckets are enough
+        float best = mergeDistance*mergeDistance;
+        for (int dy = -1; dy <= 1; dy++) {
+            for (int dx = -1; dx <= 1; dx++) {
+                Grid::iterator it = m_grid.find(key(cx + dx, cy + dy));
+                if (it == m_grid.end())
+                    continue;
+                for (size_t i = 0; i < it->second.size(); i++) {
+                    const float d = distance2(it->second[i].position, observation.position);
+                    if (d <= best) {
+                        best = d;
+                        bucket = it;
+                        closest = i;
+                    }
+                }
+            }
+        }
+    }
+
+    if (bucket == m_grid.end()) {
+        m_grid[key(cx, cy)].push_back(observation);
+        m_size++;
+        return;
+    }
+
+    // running mean of the position, latest viewpoint and heading
+    Observation& o = bucket->second[closest];
+    const float w = 1.0f/(o.count + observation.count);
+    o.position = (o.position*float(o.count) + observation.position*float(observation.count))*w;
+    o.count += observation.count;
+    o.confidence = std::max(o.confidence, observation.confidence);
+    if (observation.stamp >= o.stamp) {
+        o.yaw = observation.yaw;
+        o.viewpoint = observation.viewpoint;
+        o.viewYaw = observation.viewYaw;
+        o.stamp = observation.stamp;
+    }
+
+    // the mean may have crossed a cell border: move it to its new bucket
+    cellOf(o.position, cx, cy);
+    const int64 moved = key(cx, cy);
+    if (moved == bucket->first)
+        return;
+    const Observation merged = o;
+    std::vector<Observation>& old = bucket->second;
+    old[closest] = old.back();
+    old.pop_back();
+    if (old.empty())
+        m_grid.erase(bucket);
+    m_grid[moved].push_back(merged);
+}
+
+bool ObservationMemory::nearest(cv::Point2f position, float maxDistance, Observation& out) const
+{
+    int cx, cy;
+    cellOf(position, cx, cy);
+    const int rings = std::max(1, int(std::ceil(maxDistance/cellSize)));
+
+    bool found = false;
+    float best = maxDistance*maxDistance;
+    for (int dy = -rings; dy <= rings; dy++) {
+        for (int dx = -rings; dx <= rings; dx++) {
+            Grid::const_iterator it = m_grid.find(key(cx + dx, cy + dy));
+            if (it == m_grid.end())
+                continue;
+            for (size_t i = 0; i < it->second.size(); i++) {
+                const float d = distance2(it->second[i].position, position);
+                if (d <= best) {
+                    best = d;
+                    out = it->second[i];
+                    found = true;
+                }
+            }
+        }
+    }
+    return found;
+}
+
+void ObservationMemory::mostLikely(double now, size_t n, std::vector<Observation>& out) const
+{
+    out.clear();
+    std::vector<double> scores;
+    for (Grid::const_iterator it = m_grid.begin(); it != m_grid.end(); ++it) {
+        for (size_t i = 0; i < it->second.size(); i++) {
+            out.push_back(it->second[i]);
+            scores.push_back(likelihood(it->second[i], now));
+        }
+    }
+
+    std::vector<size_t> order(out.size());
+    for (size_t i = 0; i < order.size(); i++)
+        order[i] = i;
+    n = std::min(n, order.size());
+    std::partial_sort(order.begin(), order.begin() + n, order.end(), MoreLikely(scores));
+
+    std::vector<Observation> best(n);
+    for (size_t i = 0; i < n; i++)
+        best[i] = out[order[i]];
+    out.swap(best);
+}
+
+size_t ObservationMemory::size() const
+{
+    return m_size;
+}
+
+void ObservationMemory::clear()
+{
+    m_grid.clear();
+    m_size = 0;
+}
+
+bool ObservationMemory::save(const std::string& file) const
+{
+    // written aside then renamed over @file, so that an interrupted write leaves the last one;
+    // the extension stays last, FileStorage picks the format from it
+    const size_t slash = file.find_last_of('/');
+    size_t dot = file.find_last_of('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+        dot = file.size();
+    const std::string tmp = file.substr(0, dot) + ".tmp" + file.substr(dot);
+
+    cv::FileStorage fs(tmp, cv::FileStorage::WRITE);
+    if (!fs.isOpened())
+        return false;
+
+    fs << "observations" << "[";
+    for (Grid::const_iterator it = m_grid.begin(); it != m_grid.end(); ++it) {
+        for (size_t i = 0; i < it->second.size(); i++) {
+            const Observation& o = it->second[i];
+            fs << "{:"
+               << "position" << o.position << "yaw" << o.yaw
+               << "viewpoint" << o.viewpoint << "viewYaw" << o.viewYaw
+               << "stamp" << o.stamp << "confidence" << o.confidence << "count" << o.count
+               << "}";
+        }
+    }
+    fs << "]";
+    fs.release();
+    return std::rename(tmp.c_str(), file.c_str()) == 0;
+}
+
+bool ObservationMemory::load(const std::string& file)
+{
+    cv::FileStorage fs(file, cv::FileStorage::READ);
+    if (!fs.isOpened())
+        return false;
+
+    clear();
+    cv::FileNode observations = fs["observations"];
+    for (cv::FileNodeIterator it = observations.begin(); it != observations.end(); ++it) {
+        const cv::FileNode& node = *it;
+        Observation o;
+        std::vector<float> position, viewpoint;
+        node["position"] >> position;
+        node["viewpoint"] >> viewpoint;
+        if (position.size() != 2 || viewpoint.size() != 2)
+            continue;
+        o.position = cv::Point2f(position[0], position[1]);
+        o.viewpoint = cv::Point2f(viewpoint[0], viewpoint[1]);
+        node["yaw"] >> o.yaw;
+        node["viewYaw"] >> o.viewYaw;
+        node["stamp"] >> o.stamp;
+        node["confidence"] >> o.confidence;
+        node["count"] >> o.count;
+        o.count = std::max(o.count, 1);
+        add(o);
+    }
+    return true;
+}
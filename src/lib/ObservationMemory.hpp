@@ -0,0 +1,75 @@
+#ifndef OBSERVATIONMEMORY_HPP
+#define OBSERVATIONMEMORY_HPP
+
+////////////////////////////////////////////////////////////////////
+// File includes:
+#include <opencv2/opencv.hpp>
+
+#include <boost/unordered_map.hpp>
+
+#include <string>
+#include <vector>
+
+/**
+ * Past detection of the object, in the fixed (map) frame, meters and radians.
+ */
+struct Observation
+{
+    cv::Point2f position;   // object
+    double      yaw;        // object heading
+    cv::Point2f viewpoint;  // robot when it saw the object
+    double      viewYaw;
+    double      stamp;      // seconds
+    float       confidence; // 0..1
+    int         count;      // detections merged in this observation
+};
+
+/**
+ * Store of past detections hashed on a regular grid of cellSize meters.
+ * Detections closer than mergeDistance are merged, so the memory grows with the number of
+ * places the object was seen at, not with the number of frames.
+ * Queries within cellSize of a point only visit the 3x3 neighbouring buckets.
+ */
+class ObservationMemory
+{
+public:
+    ObservationMemory();
+
+    void add(const Observation& observation);
+
+    /**
+     * Closest observation to @position, not farther than @maxDistance meters.
+     */
+    bool nearest(cv::Point2f position, float maxDistance, Observation& out) const;
+
+    /**
+     * Up to @n observations, most likely first: confidence * exp(-(now - stamp)/decayTime).
+     */
+    void mostLikely(double now, size_t n, std::vector<Observation>& out) const;
+
+    size_t size() const;
+    void clear();
+
+    /**
+     * YAML/XML persistence through cv::FileStorage. save() writes a temporary file next to
+     * @file and renames it over @file: an interrupted save keeps the previous memory.
+     */
+    bool save(const std::string& file) const;
+    bool load(const std::string& file);
+
+    float  cellSize;        // meters
+    float  mergeDistance;   // meters
+    double decayTime;       // seconds
+
+private:
+    typedef boost::unordered_map<int64, std::vector<Observation> > Grid;
+
+    int64 key(int cx, int cy) const;
+    void cellOf(cv::Point2f position, int& cx, int& cy) const;
+    double likelihood(const Observation& observation, double now) const;
+
+    Grid   m_grid;
+    size_t m_size;
+};
+
+#endif
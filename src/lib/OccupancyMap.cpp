@@ -0,0 +1,54 @@
+////////////////////////////////////////////////////////////////////
+// File includes:
+#include "OccupancyMap.hpp"
+
+namespace
+{
+    // Lookup table indexed by the occupancy value reinterpreted as unsigned
+    cv::Mat buildOccupancyLut()
+    {
+        cv::Mat table(1, 256, CV_8U);
+        for (int i = 0; i < 256; i++) {
+            const int value = (signed char)i;
+            if (value == 0)
+                table.at<uchar>(i) = MAP_FREE;
+            else if (value > 0)
+                table.at<uchar>(i) = MAP_OCCUPIED;
+            else
+                table.at<uchar>(i) = MAP_UNKNOWN;
+        }
+        return table;
+    }
+
+    const cv::Mat& occupancyLut()
+    {
+        // built once, before any concurrent use (static initialization is guarded)
+        static const cv::Mat lut = buildOccupancyLut();
+        return lut;
+    }
+}
+
+void convertOccupancyGrid(const signed char* data, int width, int height, cv::Mat& map)
+{
+    map.create(height, width, CV_8U);
+    if (width == 0 || height == 0)
+        return;
+
+    const cv::Mat grid(height, width, CV_8U, (void*)data);
+    cv::LUT(grid, occupancyLut(), map);
+}
+
+cv::Rect applyOccupancyPatch(const signed char* data, const cv::Rect& window, cv::Mat& map)
+{
+    const cv::Rect clipped = window & cv::Rect(0, 0, map.cols, map.rows);
+    if (clipped.area() == 0)
+        return clipped;
+
+    // view of the clipped part of the patch, rows keep the stride of the full patch
+    const cv::Mat patch(window.height, window.width, CV_8U, (void*)data);
+    const cv::Mat src = patch(cv::Rect(clipped.x - window.x, clipped.y - window.y,
+                                       clipped.width, clipped.height));
+    cv::Mat dst = map(clipped);
+    cv::LUT(src, occupancyLut(), dst);
+    return clipped;
+}
@@ -0,0 +1,31 @@
+#ifndef OCCUPANCYMAP_HPP
+#define OCCUPANCYMAP_HPP
+
+////////////////////////////////////////////////////////////////////
+// File includes:
+#include <opencv2/opencv.hpp>
+
+/**
+ * Values of the 8 bits map used by the node (mapf)
+ */
+enum
+{
+    MAP_OCCUPIED = 0,
+    MAP_UNKNOWN  = 128,
+    MAP_FREE     = 255
+};
+
+/**
+ * Convert a row-major occupancy grid (-1 unknown, 0 free, 1..100 occupied, as in
+ * nav_msgs/OccupancyGrid) of size @width x @height to an 8 bits map.
+ * The conversion is a single table lookup over the buffer, @map is reallocated only if its size changes.
+ */
+void convertOccupancyGrid(const signed char* data, int width, int height, cv::Mat& map);
+
+/**
+ * Convert a patch of occupancy values (as in map_msgs/OccupancyGridUpdate) and write it
+ * in place into the @window of @map. The window is clipped to the map; returns the part written.
+ */
+cv::Rect applyOccupancyPatch(const signed char* data, const cv::Rect& window, cv::Mat& map);
+
+#endif
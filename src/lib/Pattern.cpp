@@ -1,29 +1,70 @@
 ////////////////////////////////////////////////////////////////////
 // File includes:
 #include "Pattern.hpp"
+#include "PlanarPose.hpp"
+#include "Profiler.hpp"
 
-void PatternTrackingInfo::computePose(const Pattern& pattern, const CameraCalibration& calibration){
-  cv::Mat Rvec;
-  cv::Mat_<float> Tvec;
-  cv::Mat raux,taux;
+PatternTrackingInfo::PatternTrackingInfo()
+: patternIdx(-1)
+, rvec(0,0,0)
+, tvec(0,0,0)
+, poseValid(false)
+, reprojectionError(0)
+{
+}
+
+bool PatternTrackingInfo::computePose(const Pattern& pattern, const CameraCalibration& calibration,
+                                      int refineIterations, float maxError){
+  PROFILE_SCOPE("computePose");
+
+  const cv::Matx33d K = calibration.getIntrinsic();
+  const cv::Mat& distortion = calibration.getDistorsion();
 
-  cv::solvePnP(pattern.points3d, points2d, calibration.getIntrinsic(), calibration.getDistorsion(),raux,taux);
-  raux.convertTo(Rvec,CV_32F);
-  taux.convertTo(Tvec ,CV_32F);
+  // object plane (X,Y) to pattern pixels: the 3d contour is the 2d one centered and scaled
+  const cv::Point2f& p0 = pattern.points2d[0];
+  const cv::Point2f& p2 = pattern.points2d[2];
+  const cv::Point3f& q0 = pattern.points3d[0];
+  const cv::Point3f& q2 = pattern.points3d[2];
+  const double sx = (p2.x - p0.x)/(q2.x - q0.x), sy = (p2.y - p0.y)/(q2.y - q0.y);
+  const cv::Matx33d planeToPattern(sx, 0, p0.x - sx*q0.x,
+                                   0, sy, p0.y - sy*q0.y,
+                                   0, 0, 1);
 
-  cv::Mat_<float> rotMat(3,3); 
-  cv::Rodrigues(Rvec, rotMat);
+  cv::Vec3d r, t;
+  bool found = !homography.empty()
+      && planarPoseFromHomography(cv::Matx33d(homography)*planeToPattern, K, r, t);
+  if (!found){
+    cv::Mat raux, taux;
+    cv::solvePnP(pattern.points3d, points2d, cv::Mat(K), distortion, raux, taux);
+    r = cv::Vec3d(raux);
+    t = cv::Vec3d(taux);
+  }
 
-  // Copy to transformation matrix
-  for (int col=0; col<3; col++){
-    for (int row=0; row<3; row++){        
-     pose3d.r()(row,col) = rotMat(row,col); // Copy rotation component
+  // warm start: keep the previous pose if it explains this frame better
+  double error = ::reprojectionError(pattern.points3d, points2d, K, distortion, r, t);
+  if (poseValid){
+    double previous = ::reprojectionError(pattern.points3d, points2d, K, distortion, rvec, tvec);
+    if (previous < error){
+      r = rvec;
+      t = tvec;
+      error = previous;
     }
-    pose3d.t()[col] = Tvec(col); // Copy translation component
   }
+  if (refineIterations > 0)
+    error = refinePlanarPose(pattern.points3d, points2d, K, distortion, r, t, refineIterations);
+
+  rvec = r;
+  tvec = t;
+  reprojectionError = error;
+  poseValid = error <= maxError;
+
+  cv::Matx33d rotMat;
+  cv::Rodrigues(r, rotMat);
+  pose3d = Transformation(cv::Matx33f(rotMat), cv::Vec3f(t[0], t[1], t[2]));
 
   // Since solvePnP finds camera location, w.r.t to marker pose, to get marker pose w.r.t to the camera we invert it.
   pose3d = pose3d.getInverted();
+  return poseValid;
 }
 
 void PatternTrackingInfo::draw2dContour(cv::Mat& image, cv::Scalar color) const{
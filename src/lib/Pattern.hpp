@@ -29,19 +29,31 @@ struct Pattern
  */
 struct PatternTrackingInfo
 {
+  PatternTrackingInfo();
+
   cv::Mat                   homography;
   std::vector<cv::Point2f>  points2d;
   Transformation            pose3d;
   int                       patternIdx;
 
+  // pattern to camera pose of the last computePose, kept as warm start for the next frame
+  cv::Vec3d                 rvec;
+  cv::Vec3d                 tvec;
+  bool                      poseValid;
+  float                     reprojectionError; // RMS, pixels
+
   void draw2dContour(cv::Mat& image, cv::Scalar color) const;
   void draw2dPoints(cv::Mat& image, cv::Scalar color) const;
   cv::Rect getRect(cv::Mat& image) const;
 
   /**
-   * Compute pattern pose using PnP algorithm
+   * Compute pattern pose from the homography (closed form), refined with @refineIterations
+   * Gauss-Newton steps started from the better of that pose and the previous one.
+   * Falls back to cv::solvePnP when the homography cannot be decomposed.
+   * Returns false if the reprojection error exceeds @maxError pixels.
    */
-  void computePose(const Pattern& pattern, const CameraCalibration& calibration);
+  bool computePose(const Pattern& pattern, const CameraCalibration& calibration,
+                   int refineIterations = 5, float maxError = 4.0f);
 };
 
 #endif
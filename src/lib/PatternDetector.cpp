@@ -1,6 +1,8 @@
 ////////////////////////////////////////////////////////////////////
 // File includes:
 #include "PatternDetector.hpp"
+#include "Profiler.hpp"
+#include "TaskScheduler.hpp"
 
 ////////////////////////////////////////////////////////////////////
 // Standard includes:
@@ -9,6 +11,7 @@
 #include <iostream>
 #include <iomanip>
 #include <cassert>
+#include <algorithm>
 
 PatternDetector::PatternDetector(cv::Ptr<cv::FeatureDetector> detector,
         cv::Ptr<cv::DescriptorExtractor> extractor, bool ratioTest)
@@ -18,6 +21,15 @@ PatternDetector::PatternDetector(cv::Ptr<cv::FeatureDetector> detector,
     enableHomographyRefinement=true;
     homographyReprojectionThreshold=3;
     enableRatioTest=ratioTest;
+    extractionTiles=1;
+    tileMargin=64;
+
+    // ORB keeps its nFeatures best keypoints, the tiled detection does the same
+    m_maxFeatures=0;
+    try {
+        m_maxFeatures=detector->getInt("nFeatures");
+    } catch (const cv::Exception&) {
+    }
 }
 
 void PatternDetector::train(const std::vector<Pattern>& patterns) {
@@ -122,73 +134,79 @@ void PatternDetector::buildPatternsFromYAML(
 	}
 }
 
-void PatternDetector::findPatternMatch(const cv::Mat queryDescriptors,
-		int patternIdx) {
+void PatternDetector::findPatternMatch(Workspace& ws, int patternIdx) const {
+	PROFILE_SCOPE("findPattern.match");
 	std::vector<cv::DMatch> matches;
-	matches.clear();
-	if (enableRatioTest) {
-		std::vector<std::vector<cv::DMatch> > knnMatches;
-
-		// To avoid NaN's when best match has zero distance we will use inversed ratio.
-		const float minRatio = 1.f / 1.5f;
-
-		// KNN match will return 2 nearest matches for each query descriptor
-		m_matchers[patternIdx]->knnMatch(queryDescriptors, knnMatches, 2);
-
-		for (size_t i = 0; i < knnMatches.size(); i++) {
-			const cv::DMatch& bestMatch = knnMatches[i][0];
-			const cv::DMatch& betterMatch = knnMatches[i][1];
+	getMatches(ws.queryDescriptors, matches, patternIdx);
+	PROFILE_COUNT("findPattern.matches", matches.size());
 
-			float distanceRatio = bestMatch.distance / betterMatch.distance;
-
-			// Pass only matches where distance ratio between
-			// nearest matches is greater than 1.5 (distinct criteria)
-			if (distanceRatio < minRatio) {
-				matches.push_back(bestMatch);
-			}
-		}
-	} else {
-		// Perform regular match
-		m_matchers[patternIdx]->match(queryDescriptors, matches);
-	}
 	cv::Mat roughHomography;
 	// Estimate Homography for pattern and discard outlier matches
-	bool homographyFoundinPattern = refineMatchesWithHomography(
-			m_queryKeypoints, m_patterns[patternIdx].keypoints,
-			homographyReprojectionThreshold, matches, roughHomography);
+	bool homographyFoundinPattern;
+	{
+		PROFILE_SCOPE("findPattern.ransac");
+		homographyFoundinPattern = refineMatchesWithHomography(
+				ws.queryKeypoints, m_patterns[patternIdx].keypoints,
+				homographyReprojectionThreshold, matches, roughHomography);
+	}
+	if (homographyFoundinPattern)
+		PROFILE_COUNT("findPattern.inliers", matches.size());
 
 	// Save matches and homography found
-	m_matches[patternIdx] = matches;
-	m_matches_homography[patternIdx] = roughHomography;
-	m_matches_homographyFound[patternIdx] = homographyFoundinPattern;
+	ws.matches[patternIdx].swap(matches);
+	ws.homography[patternIdx] = roughHomography;
+	ws.homographyFound[patternIdx] = homographyFoundinPattern;
 }
 
 bool PatternDetector::findPattern(const cv::Mat& image,
 		PatternTrackingInfo& info) {
+	return findPattern(image, info, m_workspace);
+}
+
+int PatternDetector::findPatternBatch(const std::vector<cv::Mat>& images,
+		std::vector<PatternTrackingInfo>& infos, std::vector<uchar>& found) const {
+	PROFILE_SCOPE("findPatternBatch");
+	infos.resize(images.size());
+	found.assign(images.size(), 0);
+
+	TaskScheduler::parallelFor(cv::Range(0, images.size()),
+			PatternBatch(*this, images, infos, found));
+
+	return int(std::count(found.begin(), found.end(), 1));
+}
+
+bool PatternDetector::findPattern(const cv::Mat& image,
+		PatternTrackingInfo& info, Workspace& ws) const {
+	PROFILE_SCOPE("findPattern");
+
 	// Convert input image to gray
-	getGray(image, m_grayImg);
+	{
+		PROFILE_SCOPE("findPattern.getGray");
+		getGray(image, ws.grayImg);
+	}
 
 	// Extract feature points from input gray image
-	extractFeatures(m_grayImg, m_queryKeypoints, m_queryDescriptors);
-
-	// Match query against each pattern in parallel
-	m_matches = std::vector<std::vector<cv::DMatch> >(m_patterns.size());
-	m_matches_homographyFound = std::vector<bool>(m_patterns.size());
-	m_matches_homography = std::vector<cv::Mat>(m_patterns.size());
+	{
+		PROFILE_SCOPE("findPattern.extract");
+		extractFeatures(ws.grayImg, ws.queryKeypoints, ws.queryDescriptors);
+	}
+	PROFILE_COUNT("findPattern.keypoints", ws.queryKeypoints.size());
 
-	//parallel_for(tbb::blocked_range<size_t>(0,m_patterns.size()), PatternMatch(m_queryDescriptors, *this));
+	// Match query against each pattern in parallel (nested in a batch, it runs on the same threads)
+	ws.matches.resize(m_patterns.size());
+	ws.homographyFound.assign(m_patterns.size(), 0);
+	ws.homography.resize(m_patterns.size());
 
-	cv::parallel_for_(cv::Range(0, m_patterns.size()),
-			PatternMatch(m_queryDescriptors, *this));
+	TaskScheduler::parallelFor(cv::Range(0, m_patterns.size()), PatternMatch(*this, ws));
 
 	// Process results
 	bool homographyFound = false;
 	int maxFound = 0;
 	int maxFoundIdx = -1;
     for (size_t i = 0; i < m_patterns.size(); i++) {
-		if (m_matches_homographyFound[i]) {
-            if (m_matches[i].size() > (size_t)maxFound) {
-				maxFound = m_matches[i].size();
+		if (ws.homographyFound[i]) {
+            if (ws.matches[i].size() > (size_t)maxFound) {
+				maxFound = ws.matches[i].size();
 				maxFoundIdx = i;
 				homographyFound = true;
 			}
@@ -199,10 +217,10 @@ bool PatternDetector::findPattern(const cv::Mat& image,
 		return false;
 	}
 
-	m_roughHomography = m_matches_homography[maxFoundIdx];
-	m_pattern = m_patterns[maxFoundIdx];
+	const cv::Mat& roughHomography = ws.homography[maxFoundIdx];
+	const Pattern& pattern = m_patterns[maxFoundIdx];
 
-	// The best fitting pattern has been detected matchedPatternIdx, m_roughHomography, homographyFound, m_pattern has been set
+	// The best fitting pattern has been detected matchedPatternIdx, roughHomography, homographyFound, pattern has been set
 	// TODO if debug, show the matches between one input frame and pattern
 
 	if (homographyFound) {
@@ -213,8 +231,12 @@ bool PatternDetector::findPattern(const cv::Mat& image,
 		// If homography refinement enabled improve found transformation
 		if (enableHomographyRefinement) {
 			// Warp image using found homography
-			cv::warpPerspective(m_grayImg, m_warpedImg, m_roughHomography,
-					m_pattern.size, cv::WARP_INVERSE_MAP | cv::INTER_CUBIC);
+			{
+				PROFILE_SCOPE("findPattern.warp");
+				cv::warpPerspective(ws.grayImg, ws.warpedImg, roughHomography,
+						pattern.size, cv::WARP_INVERSE_MAP | cv::INTER_CUBIC);
+			}
+			PROFILE_SCOPE("findPattern.refine");
 			// TODO if debug, show the input frame warped according to input frame
 
 			// Get refined matches:
@@ -223,7 +245,7 @@ bool PatternDetector::findPattern(const cv::Mat& image,
 			std::vector<cv::DMatch> refinedMatches;
 
 			// Detect features on warped image
-			extractFeatures(m_warpedImg, warpedKeypoints,
+			extractFeatures(ws.warpedImg, warpedKeypoints,
 					m_newQueryDescriptors);
 
 			// Match with pattern
@@ -231,31 +253,35 @@ bool PatternDetector::findPattern(const cv::Mat& image,
 
 			// Estimate new refinement homography
 			homographyFound = refineMatchesWithHomography(warpedKeypoints,
-					m_pattern.keypoints, homographyReprojectionThreshold,
-					refinedMatches, m_refinedHomography);
+					pattern.keypoints, homographyReprojectionThreshold,
+					refinedMatches, ws.refinedHomography);
+
+			// Not confirmed on the warped image: not found. ws.refinedHomography was not
+			// written, it is empty in a fresh Workspace or holds the one of an earlier frame
+			if (!homographyFound)
+				return false;
 
 			// TODO if debug, show the matches between warped input and pattern
 
 			// Get a result homography as result of matrix product of refined and rough homographies:
-			info.homography = m_roughHomography * m_refinedHomography;
+			info.homography = roughHomography * ws.refinedHomography;
 
 			// Transform contour with rough homography
 			// TODO if debug, apply homography to originla points to get new location in scene. Draw contors connecting the points.
 
 			// Transform contour with precise homography
-			cv::perspectiveTransform(m_pattern.points2d, info.points2d,
+			cv::perspectiveTransform(pattern.points2d, info.points2d,
 					info.homography);
 		} else {
-			info.homography = m_roughHomography;
+			info.homography = roughHomography.clone();
 
 			// Transform contour with rough homography
-			cv::perspectiveTransform(m_pattern.points2d, info.points2d,
-					m_roughHomography);
+			cv::perspectiveTransform(pattern.points2d, info.points2d,
+					roughHomography);
 		}
 	}
 
 	// TODO if debug, show final matches
-	// TODO if debug, report the number of features and the number of matches
 	return homographyFound;
 }
 
@@ -273,7 +299,10 @@ bool PatternDetector::extractFeatures(const cv::Mat& image,
 	assert(!image.empty());
 	assert(image.channels() == 1);
 
-	m_detector->detect(image, keypoints);
+	if (extractionTiles > 1 && image.rows >= 2*extractionTiles*tileMargin)
+		detectTiled(image, keypoints);
+	else
+		m_detector->detect(image, keypoints);
 	if (keypoints.empty())
 		return false;
 
@@ -289,8 +318,41 @@ bool PatternDetector::extractFeatures(const cv::Mat& image,
 	return true;
 }
 
+void PatternDetector::TileDetect::operator() (const cv::Range& range) const {
+	for (int i = range.start; i != range.end; i++) {
+		// band [top, bottom) owns its keypoints, it is detected with a margin around
+		const int top = image.rows*i/int(tiles.size());
+		const int bottom = image.rows*(i + 1)/int(tiles.size());
+		const int from = std::max(top - parent.tileMargin, 0);
+		const int to = std::min(bottom + parent.tileMargin, image.rows);
+
+		std::vector<cv::KeyPoint> keypoints;
+		parent.m_detector->detect(image.rowRange(from, to), keypoints);
+
+		tiles[i].clear();
+		for (size_t k = 0; k < keypoints.size(); k++) {
+			cv::KeyPoint kp = keypoints[k];
+			kp.pt.y += from;
+			if (kp.pt.y >= top && kp.pt.y < bottom)
+				tiles[i].push_back(kp);
+		}
+	}
+}
+
+void PatternDetector::detectTiled(const cv::Mat& image,
+		std::vector<cv::KeyPoint>& keypoints) const {
+	std::vector<std::vector<cv::KeyPoint> > tiles(extractionTiles);
+	TaskScheduler::parallelFor(cv::Range(0, extractionTiles), TileDetect(*this, image, tiles));
+
+	keypoints.clear();
+	for (size_t i = 0; i < tiles.size(); i++)
+		keypoints.insert(keypoints.end(), tiles[i].begin(), tiles[i].end());
+	if (m_maxFeatures > 0)
+		cv::KeyPointsFilter::retainBest(keypoints, m_maxFeatures);
+}
+
 void PatternDetector::getMatches(const cv::Mat& queryDescriptors,
-		std::vector<cv::DMatch>& matches, int patternIdx) {
+		std::vector<cv::DMatch>& matches, int patternIdx) const {
 	matches.clear();
 
     if (enableRatioTest) {
@@ -11,6 +11,26 @@
 class PatternDetector
 {
 public:
+    /**
+     * Scratch state of one findPattern call. The trained detector itself is not modified by
+     * findPattern(image, info, workspace), so one trained detector can be shared by several
+     * threads as long as each has its own workspace.
+     */
+    struct Workspace
+    {
+        cv::Mat                   grayImg;
+        std::vector<cv::KeyPoint> queryKeypoints;
+        cv::Mat                   queryDescriptors;
+
+        // per pattern
+        std::vector<std::vector<cv::DMatch> > matches;
+        std::vector<uchar>        homographyFound;
+        std::vector<cv::Mat>      homography;
+
+        cv::Mat                   warpedImg;
+        cv::Mat                   refinedHomography;
+    };
+
     /**
      * Initialize a pattern detector with specified feature detector, descriptor extraction and matching algorithm
      */
@@ -41,16 +61,37 @@ public:
     */
     bool findPattern(const cv::Mat& image, PatternTrackingInfo& info);
 
+    /**
+    * Same as above, with the scratch state in @workspace. Can be called concurrently.
+    */
+    bool findPattern(const cv::Mat& image, PatternTrackingInfo& info, Workspace& workspace) const;
+
+    /**
+    * Look for the patterns in every image of @images, processed in parallel (TaskScheduler)
+    * with the trained model shared by all the threads.
+    * @infos and @found get one entry per image. Returns the number of images the pattern was found in.
+    */
+    int findPatternBatch(const std::vector<cv::Mat>& images, std::vector<PatternTrackingInfo>& infos,
+                         std::vector<uchar>& found) const;
+
     bool enableRatioTest;
     bool enableHomographyRefinement;
     float homographyReprojectionThreshold;
 
+    /**
+    * Number of horizontal bands the keypoints are detected in, as parallel tasks (1: whole
+    * image at once). The bands overlap by tileMargin pixels; the keypoints of the coarsest
+    * pyramid levels near the band borders can differ from a detection on the whole image.
+    */
+    int extractionTiles;
+    int tileMargin;
+
 protected:
 
     bool extractFeatures(const cv::Mat& image, std::vector<cv::KeyPoint>& keypoints, cv::Mat& descriptors) const;
 
-    void findPatternMatch(const cv::Mat queryDescriptors, int patternNumber);
-    void getMatches(const cv::Mat& queryDescriptors, std::vector<cv::DMatch>& matches, int patternIdx);
+    void findPatternMatch(Workspace& workspace, int patternNumber) const;
+    void getMatches(const cv::Mat& queryDescriptors, std::vector<cv::DMatch>& matches, int patternIdx) const;
 
     /**
     * Get the gray image from the input image.
@@ -70,37 +111,62 @@ protected:
         cv::Mat& homography);
 
 private:
-    std::vector<cv::KeyPoint> m_queryKeypoints;
-    cv::Mat                   m_queryDescriptors;
-
-    std::vector<std::vector<cv::DMatch> > m_matches;
-    std::vector<bool> m_matches_homographyFound;
-    std::vector<cv::Mat> m_matches_homography;
+    void detectTiled(const cv::Mat& image, std::vector<cv::KeyPoint>& keypoints) const;
 
-    cv::Mat                   m_grayImg;
-    cv::Mat                   m_warpedImg;
-    cv::Mat                   m_roughHomography;
-    cv::Mat                   m_refinedHomography;
+    Workspace                        m_workspace; // of findPattern(image, info)
+    int                              m_maxFeatures; // keypoints the detector keeps, 0 if unknown
 
+    // trained model, read only while detecting (ORB and the brute force matchers
+    // keep no per-call state)
     std::vector<Pattern>             m_patterns;
-    Pattern                          m_pattern;
     cv::Ptr<cv::FeatureDetector>     m_detector;
     cv::Ptr<cv::DescriptorExtractor> m_extractor;
     std::vector<cv::Ptr<cv::DescriptorMatcher> > m_matchers;
 
     class PatternMatch : public cv::ParallelLoopBody {
-        cv::Mat queryDescriptors;
-        PatternDetector& parent;
+        const PatternDetector& parent;
+        Workspace& workspace;
 
     public:
-        PatternMatch(cv::Mat& queryDescriptors, PatternDetector& parent) : queryDescriptors(queryDescriptors), parent(parent) {}
+        PatternMatch(const PatternDetector& parent, Workspace& workspace) : parent(parent), workspace(workspace) {}
 
         void operator() (const cv::Range& range) const {
             for (int i = range.start; i != range.end; i++) {
-                parent.findPatternMatch(queryDescriptors, i);
+                parent.findPatternMatch(workspace, i);
             }
         }
     };
+
+    class PatternBatch : public cv::ParallelLoopBody {
+        const PatternDetector& parent;
+        const std::vector<cv::Mat>& images;
+        std::vector<PatternTrackingInfo>& infos;
+        std::vector<uchar>& found;
+
+    public:
+        PatternBatch(const PatternDetector& parent, const std::vector<cv::Mat>& images,
+                     std::vector<PatternTrackingInfo>& infos, std::vector<uchar>& found)
+            : parent(parent), images(images), infos(infos), found(found) {}
+
+        void operator() (const cv::Range& range) const {
+            Workspace workspace;
+            for (int i = range.start; i != range.end; i++) {
+                found[i] = parent.findPattern(images[i], infos[i], workspace);
+            }
+        }
+    };
+
+    class TileDetect : public cv::ParallelLoopBody {
+        const PatternDetector& parent;
+        const cv::Mat& image;
+        std::vector<std::vector<cv::KeyPoint> >& tiles;
+
+    public:
+        TileDetect(const PatternDetector& parent, const cv::Mat& image, std::vector<std::vector<cv::KeyPoint> >& tiles)
+            : parent(parent), image(image), tiles(tiles) {}
+
+        void operator() (const cv::Range& range) const;
+    };
 };
 
 #endif
@@ -0,0 +1,118 @@
+////////////////////////////////////////////////////////////////////
+// File includes:
+#include "PlanarPose.hpp"
+#include "GeometryTypes.hpp"
+
+////////////////////////////////////////////////////////////////////
+// Standard includes:
+#include <cmath>
+
+bool planarPoseFromHomography(const cv::Matx33d& H, const cv::Matx33d& K, cv::Vec3d& rvec, cv::Vec3d& tvec)
+{
+    const cv::Matx33d M = K.inv()*H;
+    cv::Vec3d h1(M(0,0), M(1,0), M(2,0));
+    cv::Vec3d h2(M(0,1), M(1,1), M(2,1));
+    cv::Vec3d h3(M(0,2), M(1,2), M(2,2));
+
+    const double n1 = cv::norm(h1), n2 = cv::norm(h2);
+    if (n1 < 1e-12 || n2 < 1e-12)
+        return false;
+
+    // the plane origin must be in front of the camera
+    double lambda = 2.0/(n1 + n2);
+    if (h3[2] < 0)
+        lambda = -lambda;
+
+    const cv::Vec3d r1 = h1*lambda, r2 = h2*lambda;
+    const cv::Vec3d r3 = r1.cross(r2);
+    cv::Matx33d R(r1[0], r2[0], r3[0],
+                  r1[1], r2[1], r3[1],
+                  r1[2], r2[2], r3[2]);
+
+    // closest rotation: R = U V^T
+    cv::SVD svd(cv::Mat(R), cv::SVD::FULL_UV);
+    cv::Mat_<double> Rn = svd.u*svd.vt;
+    if (cv::determinant(Rn) < 0)
+        return false;
+
+    cv::Rodrigues(Rn, rvec);
+    tvec = h3*lambda;
+    return true;
+}
+
+double reprojectionError(const std::vector<cv::Point3f>& objectPoints, const std::vector<cv::Point2f>& imagePoints,
+                         const cv::Matx33d& K, const cv::Mat& distortion,
+                         const cv::Vec3d& rvec, const cv::Vec3d& tvec)
+{
+    if (objectPoints.empty())
+        return 0;
+
+    std::vector<cv::Point2f> projected(objectPoints.size());
+    if (distortion.empty() || cv::countNonZero(distortion) == 0) {
+        // pinhole only: the batch kernel instead of the generic distortion model
+        cv::Matx33d R;
+        cv::Rodrigues(rvec, R);
+        const Transformation pose(cv::Matx33f(R), cv::Vec3f(tvec[0], tvec[1], tvec[2]));
+        pose.projectPoints(&objectPoints[0], objectPoints.size(), cv::Matx33f(K), &projected[0]);
+    } else {
+        cv::projectPoints(objectPoints, rvec, tvec, cv::Mat(K), distortion, projected);
+    }
+
+    double sum = 0;
+    for (size_t i = 0; i < projected.size(); i++) {
+        const cv::Point2f d = projected[i] - imagePoints[i];
+        sum += d.x*d.x + d.y*d.y;
+    }
+    return std::sqrt(sum/projected.size());
+}
+
+double refinePlanarPose(const std::vector<cv::Point3f>& objectPoints, const std::vector<cv::Point2f>& imagePoints,
+                        const cv::Matx33d& K, const cv::Mat& distortion,
+                        cv::Vec3d& rvec, cv::Vec3d& tvec, int iterations)
+{
+    CV_Assert(objectPoints.size() == imagePoints.size());
+    const int n = objectPoints.size();
+    const cv::Mat Kmat(K);
+
+    std::vector<cv::Point2f> projected;
+    cv::Mat jacobian;
+    double lambda = 1e-3;
+    double error = reprojectionError(objectPoints, imagePoints, K, distortion, rvec, tvec);
+
+    for (int it = 0; it < iterations && n >= 3; it++) {
+        // d(projection)/d(rvec, tvec) are the first 6 columns
+        cv::projectPoints(objectPoints, rvec, tvec, Kmat, distortion, projected, jacobian);
+        cv::Mat J = jacobian.colRange(0, 6);
+
+        cv::Mat_<double> r(2*n, 1);
+        for (int i = 0; i < n; i++) {
+            r(2*i)   = projected[i].x - imagePoints[i].x;
+            r(2*i+1) = projected[i].y - imagePoints[i].y;
+        }
+
+        cv::Mat JtJ = J.t()*J;
+        cv::Mat Jtr = J.t()*r;
+        JtJ += cv::Mat::diag(JtJ.diag())*lambda;
+
+        cv::Mat_<double> delta;
+        if (!cv::solve(JtJ, -Jtr, delta, cv::DECOMP_CHOLESKY))
+            break;
+
+        const cv::Vec3d newR = rvec + cv::Vec3d(delta(0), delta(1), delta(2));
+        const cv::Vec3d newT = tvec + cv::Vec3d(delta(3), delta(4), delta(5));
+        const double newError = reprojectionError(objectPoints, imagePoints, K, distortion, newR, newT);
+
+        if (newError < error) {
+            rvec = newR;
+            tvec = newT;
+            const double gain = error - newError;
+            error = newError;
+            lambda *= 0.1;
+            if (gain < 1e-4)
+                break;
+        } else {
+            lambda *= 10;
+        }
+    }
+    return error;
+}
@@ -0,0 +1,36 @@
+#ifndef PLANARPOSE_HPP
+#define PLANARPOSE_HPP
+
+////////////////////////////////////////////////////////////////////
+// File includes:
+#include <opencv2/opencv.hpp>
+
+#include <vector>
+
+/**
+ * Pose of a plane (Z = 0 in object coordinates) from the homography @H mapping object
+ * points (X, Y, 1) to pixels, by decomposition of K^-1 H = lambda [r1 r2 t].
+ * The rotation is projected on SO(3) and the plane is put in front of the camera.
+ * Distortion is ignored here; refinePlanarPose() accounts for it.
+ * (@rvec, @tvec) map object points to the camera frame, as with cv::solvePnP.
+ */
+bool planarPoseFromHomography(const cv::Matx33d& H, const cv::Matx33d& K, cv::Vec3d& rvec, cv::Vec3d& tvec);
+
+/**
+ * RMS reprojection error (pixels) of @objectPoints against @imagePoints.
+ * Without distortion the points go through Transformation::projectPoints.
+ */
+double reprojectionError(const std::vector<cv::Point3f>& objectPoints, const std::vector<cv::Point2f>& imagePoints,
+                         const cv::Matx33d& K, const cv::Mat& distortion,
+                         const cv::Vec3d& rvec, const cv::Vec3d& tvec);
+
+/**
+ * Damped Gauss-Newton on the reprojection error, starting from (@rvec, @tvec).
+ * Jacobians come from cv::projectPoints. Stops after @iterations or when the step is negligible.
+ * Returns the final RMS reprojection error in pixels.
+ */
+double refinePlanarPose(const std::vector<cv::Point3f>& objectPoints, const std::vector<cv::Point2f>& imagePoints,
+                        const cv::Matx33d& K, const cv::Mat& distortion,
+                        cv::Vec3d& rvec, cv::Vec3d& tvec, int iterations = 5);
+
+#endif
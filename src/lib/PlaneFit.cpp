@@ -0,0 +1,192 @@
+////////////////////////////////////////////////////////////////////
+// File includes:
+#include "PlaneFit.hpp"
+#include "DepthValue.hpp"
+
+////////////////////////////////////////////////////////////////////
+// Standard includes:
+#include <cmath>
+
+namespace
+{
+    // First and second order moments of a point set
+    struct PlaneMoments
+    {
+        double n, x, y, z, xx, xy, xz, yy, yz, zz;
+        PlaneMoments() : n(0), x(0), y(0), z(0), xx(0), xy(0), xz(0), yy(0), yz(0), zz(0) {}
+    };
+
+    // Back-projection of pixel (j,i) of the ROI: (x,y) = rays(i,j)*z, z = depth*scale
+    struct BackProjection
+    {
+        cv::Mat_<cv::Vec2f> rays;
+        double scale;
+    };
+
+    /**
+     * One pass over the ROI. If @plane is given, only the points closer than @threshold
+     * to it are accumulated.
+     */
+    template <typename T>
+    void accumulatePlane(const cv::Mat& depth, const cv::Mat& mask, const BackProjection& bp,
+                         const cv::Vec4d* plane, double threshold, PlaneMoments& m)
+    {
+        for (int i = 0; i < depth.rows; i++) {
+            const T* zrow = depth.ptr<T>(i);
+            const uchar* mrow = mask.empty() ? 0 : mask.ptr<uchar>(i);
+            const cv::Vec2f* rrow = bp.rays[i];
+
+            PlaneMoments r;
+            for (int j = 0; j < depth.cols; j++) {
+                const T zraw = zrow[j];
+                bool use = isValidDepth(zraw) && (mrow == 0 || mrow[j] != 0);
+                const double z = use ? double(zraw)*bp.scale : 0.0;
+                const double x = rrow[j][0]*z;
+                const double y = rrow[j][1]*z;
+
+                if (plane) {
+                    const cv::Vec4d& p = *plane;
+                    use = use && std::fabs(p[0]*x + p[1]*y + p[2]*z + p[3]) < threshold;
+                }
+                const double w = use ? 1.0 : 0.0;
+
+                r.n += w;
+                r.x += w*x;  r.y += w*y;  r.z += w*z;
+                r.xx += w*x*x; r.xy += w*x*y; r.xz += w*x*z;
+                r.yy += w*y*y; r.yz += w*y*z; r.zz += w*z*z;
+            }
+            m.n += r.n;
+            m.x += r.x;  m.y += r.y;  m.z += r.z;
+            m.xx += r.xx; m.xy += r.xy; m.xz += r.xz;
+            m.yy += r.yy; m.yz += r.yz; m.zz += r.zz;
+        }
+    }
+
+    /**
+     * Closed form fit: centroid and smallest eigenvector of the covariance.
+     */
+    bool solvePlane(const PlaneMoments& m, FacePlane& plane)
+    {
+        if (m.n < 3)
+            return false;
+
+        const double inv = 1.0/m.n;
+        const double cx = m.x*inv, cy = m.y*inv, cz = m.z*inv;
+
+        cv::Matx33d cov;
+        cov(0,0) = m.xx*inv - cx*cx;
+        cov(0,1) = cov(1,0) = m.xy*inv - cx*cy;
+        cov(0,2) = cov(2,0) = m.xz*inv - cx*cz;
+        cov(1,1) = m.yy*inv - cy*cy;
+        cov(1,2) = cov(2,1) = m.yz*inv - cy*cz;
+        cov(2,2) = m.zz*inv - cz*cz;
+
+        // eigenvalues in descending order, eigenvectors as rows
+        cv::Mat evals, evecs;
+        if (!cv::eigen(cv::Mat(cov), evals, evecs))
+            return false;
+
+        // points on a line (or a single point) do not define a plane
+        if (!(evals.at<double>(1) > 1e-12))
+            return false;
+
+        cv::Vec3d n(evecs.at<double>(2,0), evecs.at<double>(2,1), evecs.at<double>(2,2));
+        // orient the normal towards the camera (origin of the frame)
+        if (n[0]*cx + n[1]*cy + n[2]*cz > 0)
+            n = -n;
+
+        plane.centroid = cv::Point3f(cx, cy, cz);
+        plane.normal = cv::Vec3f(n[0], n[1], n[2]);
+        plane.rms = std::sqrt(std::max(evals.at<double>(2), 0.0));
+        plane.count = int(m.n);
+        plane.valid = true;
+        return true;
+    }
+
+    template <typename T>
+    bool samplePoint(const cv::Mat& depth, const cv::Mat& mask, const BackProjection& bp,
+                     cv::RNG& rng, cv::Vec3d& p)
+    {
+        for (int attempt = 0; attempt < 20; attempt++) {
+            const int i = rng.uniform(0, depth.rows);
+            const int j = rng.uniform(0, depth.cols);
+            const T zraw = depth.at<T>(i,j);
+            if (!isValidDepth(zraw) || (!mask.empty() && mask.at<uchar>(i,j) == 0))
+                continue;
+
+            const double z = double(zraw)*bp.scale;
+            const cv::Vec2f& ray = bp.rays(i,j);
+            p = cv::Vec3d(ray[0]*z, ray[1]*z, z);
+            return true;
+        }
+        return false;
+    }
+
+    template <typename T>
+    bool fitPlane(const cv::Mat& depth, const cv::Mat& mask, const BackProjection& bp, FacePlane& plane,
+                  PlaneFitMode mode, int ransacIterations, float ransacThreshold)
+    {
+        PlaneMoments all;
+        accumulatePlane<T>(depth, mask, bp, 0, 0, all);
+        if (mode == PLANE_FIT_PCA || all.n < 3)
+            return solvePlane(all, plane);
+
+        cv::RNG rng(0x1234abcd);
+        PlaneMoments best;
+        for (int it = 0; it < ransacIterations; it++) {
+            cv::Vec3d p1, p2, p3;
+            if (!samplePoint<T>(depth, mask, bp, rng, p1) ||
+                !samplePoint<T>(depth, mask, bp, rng, p2) ||
+                !samplePoint<T>(depth, mask, bp, rng, p3))
+                continue;
+
+            cv::Vec3d n = (p2 - p1).cross(p3 - p1);
+            const double norm = cv::norm(n);
+            if (norm < 1e-12)
+                continue;
+            n *= 1.0/norm;
+            const cv::Vec4d hypothesis(n[0], n[1], n[2], -n.dot(p1));
+
+            PlaneMoments inliers;
+            accumulatePlane<T>(depth, mask, bp, &hypothesis, ransacThreshold, inliers);
+            if (inliers.n > best.n) {
+                best = inliers;
+                // good enough, stop sampling
+                if (best.n >= 0.95*all.n)
+                    break;
+            }
+        }
+
+        // refit on the inliers of the best hypothesis, or on everything if RANSAC failed
+        return solvePlane(best.n >= 3 ? best : all, plane);
+    }
+}
+
+bool fitDepthPlane(const cv::Mat& depth, const cv::Mat& mask, cv::Point offset,
+                   const CameraCalibration& calibration, float depthScale, FacePlane& plane,
+                   PlaneFitMode mode, int ransacIterations, float ransacThreshold)
+{
+    plane.centroid = cv::Point3f(0, 0, 0);
+    plane.normal = cv::Vec3f(0, 0, -1);
+    plane.rms = 0;
+    plane.count = 0;
+    plane.valid = false;
+
+    if (depth.empty() || calibration.fx() == 0 || calibration.fy() == 0)
+        return false;
+    CV_Assert(mask.empty() || (mask.type() == CV_8UC1 && mask.size() == depth.size()));
+
+    BackProjection bp;
+    bp.rays = calibration.getRays(cv::Rect(offset, depth.size()));
+    bp.scale = depthScale;
+
+    switch (depth.type()) {
+    case CV_16UC1:
+        return fitPlane<unsigned short>(depth, mask, bp, plane, mode, ransacIterations, ransacThreshold);
+    case CV_32FC1:
+        return fitPlane<float>(depth, mask, bp, plane, mode, ransacIterations, ransacThreshold);
+    default:
+        CV_Error(CV_StsUnsupportedFormat, "fitDepthPlane: depth must be CV_16UC1 or CV_32FC1");
+    }
+    return false;
+}
@@ -0,0 +1,43 @@
+#ifndef PLANEFIT_HPP
+#define PLANEFIT_HPP
+
+////////////////////////////////////////////////////////////////////
+// File includes:
+#include "CameraCalibration.hpp"
+
+#include <opencv2/opencv.hpp>
+
+/**
+ * Plane of the visible face of an object, in the camera optical frame (meters).
+ */
+struct FacePlane
+{
+    cv::Point3f centroid;
+    cv::Vec3f   normal;     // unit normal, pointing towards the camera
+    float       rms;        // rms point to plane distance
+    int         count;      // number of points of the fit
+    bool        valid;
+};
+
+enum PlaneFitMode
+{
+    PLANE_FIT_PCA,      // closed form fit on all the masked points
+    PLANE_FIT_RANSAC    // RANSAC on the masked points, then closed form fit on the inliers
+};
+
+/**
+ * Back-project the masked pixels of a depth ROI with the camera intrinsics (the ray table
+ * of @calibration when it has been built) and fit a plane to them.
+ * @depth is a CV_16UC1 or CV_32FC1 ROI whose top-left corner is at @offset in the image,
+ * @mask a CV_8UC1 mask of the same size (empty means every pixel),
+ * @depthScale converts the depth values to meters.
+ * The first and second order moments are accumulated in one pass and the plane is the
+ * eigenvector of the smallest eigenvalue of their covariance.
+ * The RANSAC mode uses a fixed seed so results are repeatable.
+ */
+bool fitDepthPlane(const cv::Mat& depth, const cv::Mat& mask, cv::Point offset,
+                   const CameraCalibration& calibration, float depthScale, FacePlane& plane,
+                   PlaneFitMode mode = PLANE_FIT_PCA,
+                   int ransacIterations = 50, float ransacThreshold = 0.01f);
+
+#endif
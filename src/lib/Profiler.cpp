@@ -0,0 +1,216 @@
+////////////////////////////////////////////////////////////////////
+// File includes:
+#include "Profiler.hpp"
+
+////////////////////////////////////////////////////////////////////
+// Standard includes:
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+    // values < 16 are exact, then 16 sub-buckets per power of two
+    const int SUB_BUCKETS = 16;
+    const int BUCKETS = (64 - 3)*SUB_BUCKETS;
+
+    inline int bucketOf(uint64 v)
+    {
+        if (v < uint64(SUB_BUCKETS))
+            return int(v);
+        const int e = 63 - __builtin_clzll(v);  // >= 4
+        const int m = int(v >> (e - 4)) & (SUB_BUCKETS - 1);
+        return (e - 3)*SUB_BUCKETS + m;
+    }
+
+    // middle of the bucket
+    inline double valueOf(int bucket)
+    {
+        if (bucket < SUB_BUCKETS)
+            return bucket;
+        const int e = bucket/SUB_BUCKETS + 3;
+        const int m = bucket % SUB_BUCKETS;
+        const double width = double(uint64(1) << (e - 4));
+        return (SUB_BUCKETS + m)*width + width/2;
+    }
+
+    struct Histograms
+    {
+        unsigned buckets[Profiler::MAX_STAGES][BUCKETS];
+        uint64 count[Profiler::MAX_STAGES];
+        uint64 sum[Profiler::MAX_STAGES];
+        uint64 max[Profiler::MAX_STAGES];
+
+        Histograms() { clear(); }
+        void clear() { std::memset(this, 0, sizeof(*this)); }
+
+        void merge(const Histograms& other)
+        {
+            for (int s = 0; s < Profiler::MAX_STAGES; s++) {
+                if (other.count[s] == 0)
+                    continue;
+                for (int b = 0; b < BUCKETS; b++)
+                    buckets[s][b] += other.buckets[s][b];
+                count[s] += other.count[s];
+                sum[s] += other.sum[s];
+                max[s] = std::max(max[s], other.max[s]);
+            }
+        }
+    };
+
+    struct Stage
+    {
+        std::string name;
+        bool timer;
+    };
+
+    // registry of the stages and of the histograms of every thread;
+    // the mutex is taken on registration, thread start/exit and summaries, never when recording
+    boost::mutex registryMutex;
+    std::vector<Stage> stages;
+    std::vector<Histograms*> threads;
+    Histograms retired;     // merged histograms of the threads that exited
+    volatile bool enabled = true;
+
+    void retireThread(Histograms* h)
+    {
+        boost::mutex::scoped_lock lock(registryMutex);
+        retired.merge(*h);
+        threads.erase(std::remove(threads.begin(), threads.end(), h), threads.end());
+        delete h;
+    }
+
+    boost::thread_specific_ptr<Histograms> threadHistograms(retireThread);
+
+    Histograms& localHistograms()
+    {
+        Histograms* h = threadHistograms.get();
+        if (!h) {
+            h = new Histograms();
+            {
+                boost::mutex::scoped_lock lock(registryMutex);
+                threads.push_back(h);
+            }
+            threadHistograms.reset(h);
+        }
+        return *h;
+    }
+
+    double percentile(const unsigned* buckets, uint64 count, double p)
+    {
+        const uint64 rank = uint64(p*(count - 1));
+        uint64 seen = 0;
+        for (int b = 0; b < BUCKETS; b++) {
+            seen += buckets[b];
+            if (seen > rank)
+                return valueOf(b);
+        }
+        return valueOf(BUCKETS - 1);
+    }
+}
+
+int Profiler::stageId(const char* name, bool timer)
+{
+    boost::mutex::scoped_lock lock(registryMutex);
+    for (size_t i = 0; i < stages.size(); i++)
+        if (stages[i].name == name)
+            return i;
+    if (stages.size() >= size_t(MAX_STAGES))
+        return -1;
+
+    Stage s;
+    s.name = name;
+    s.timer = timer;
+    stages.push_back(s);
+    return stages.size() - 1;
+}
+
+void Profiler::record(int stage, uint64 value)
+{
+    if (stage < 0 || stage >= MAX_STAGES)
+        return;
+    Histograms& h = localHistograms();
+    h.buckets[stage][bucketOf(value)]++;
+    h.count[stage]++;
+    h.sum[stage] += value;
+    if (value > h.max[stage])
+        h.max[stage] = value;
+}
+
+void Profiler::summary(std::vector<StageStats>& stats)
+{
+    stats.clear();
+
+    // the histograms of the running threads may be updated meanwhile: a summary can miss
+    // the last few records, which is fine for monitoring
+    Histograms* all = new Histograms();
+    std::vector<Stage> names;
+    {
+        boost::mutex::scoped_lock lock(registryMutex);
+        all->merge(retired);
+        for (size_t i = 0; i < threads.size(); i++)
+            all->merge(*threads[i]);
+        names = stages;
+    }
+    for (size_t s = 0; s < names.size(); s++) {
+        if (all->count[s] == 0)
+            continue;
+        const double scale = names[s].timer ? 1e-6 : 1.0;
+
+        StageStats st;
+        st.name = names[s].name;
+        st.timer = names[s].timer;
+        st.count = all->count[s];
+        st.mean = scale*all->sum[s]/all->count[s];
+        st.p50 = scale*percentile(all->buckets[s], st.count, 0.50);
+        st.p90 = scale*percentile(all->buckets[s], st.count, 0.90);
+        st.p99 = scale*percentile(all->buckets[s], st.count, 0.99);
+        st.max = scale*all->max[s];
+        stats.push_back(st);
+    }
+    delete all;
+}
+
+std::string Profiler::report()
+{
+    std::vector<StageStats> stats;
+    summary(stats);
+
+    std::string out;
+    char line[256];
+    for (size_t i = 0; i < stats.size(); i++) {
+        const StageStats& s = stats[i];
+        std::snprintf(line, sizeof(line), "%-28s n=%-8llu mean %9.3f  p50 %9.3f  p90 %9.3f  p99 %9.3f  max %9.3f %s\n",
+                      s.name.c_str(), (unsigned long long)s.count, s.mean, s.p50, s.p90, s.p99, s.max,
+                      s.timer ? "ms" : "");
+        out += line;
+    }
+    return out;
+}
+
+void Profiler::reset()
+{
+    boost::mutex::scoped_lock lock(registryMutex);
+    retired.clear();
+    for (size_t i = 0; i < threads.size(); i++)
+        threads[i]->clear();
+}
+
+void Profiler::setEnabled(bool e)
+{
+    enabled = e;
+}
+
+bool Profiler::isEnabled()
+{
+    return enabled;
+}
+
+double ScopedTimer::nsPerTick()
+{
+    static const double ns = 1e9/cv::getTickFrequency();
+    return ns;
+}
@@ -0,0 +1,110 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+////////////////////////////////////////////////////////////////////
+// File includes:
+#include "Tracer.hpp"
+
+#include <opencv2/core/core.hpp>
+
+#include <string>
+#include <vector>
+
+/**
+ * Distribution of the values recorded for one stage.
+ * Timers are reported in milliseconds, counters in their own unit.
+ */
+struct StageStats
+{
+    std::string name;
+    bool        timer;
+    uint64      count;
+    double      mean;
+    double      p50;
+    double      p90;
+    double      p99;
+    double      max;
+};
+
+/**
+ * Latency and counter histograms per named stage.
+ * Every thread records into its own log-bucketed histograms (16 sub-buckets per power of two,
+ * about 6% resolution) without locks; summary() merges them. Stages are registered once
+ * (see PROFILE_SCOPE and PROFILE_COUNT) and identified by a small integer afterwards.
+ */
+class Profiler
+{
+public:
+    enum { MAX_STAGES = 32 };
+
+    /**
+     * Id of the stage @name, registered on first use. -1 when there are too many stages.
+     */
+    static int stageId(const char* name, bool timer = true);
+
+    /**
+     * Record @value (nanoseconds for timers) for @stage, in the histograms of the calling thread.
+     */
+    static void record(int stage, uint64 value);
+
+    static void summary(std::vector<StageStats>& stats);
+
+    /**
+     * One line per stage that recorded something.
+     */
+    static std::string report();
+
+    static void reset();
+
+    static void setEnabled(bool enabled);
+    static bool isEnabled();
+};
+
+/**
+ * Records the lifetime of the object in the histograms of @stage.
+ */
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer(int stage)
+    : m_stage(Profiler::isEnabled() ? stage : -1)
+    , m_start(m_stage >= 0 ? cv::getTickCount() : 0)
+    {
+    }
+
+    ~ScopedTimer()
+    {
+        if (m_stage >= 0)
+            Profiler::record(m_stage, uint64((cv::getTickCount() - m_start)*nsPerTick()));
+    }
+
+private:
+    static double nsPerTick();
+
+    int   m_stage;
+    int64 m_start;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+/**
+ * Time the rest of the enclosing scope as stage @name (a string literal).
+ * The scope is also a span of the trace when the Tracer is enabled.
+ */
+#define PROFILE_SCOPE(name) \
+    static const int PROFILE_CONCAT(profileStage_, __LINE__) = Profiler::stageId(name, true); \
+    ScopedTimer PROFILE_CONCAT(profileTimer_, __LINE__)(PROFILE_CONCAT(profileStage_, __LINE__)); \
+    TRACE_SCOPE(name)
+
+/**
+ * Record the counter @value (keypoints, matches, ...) as stage @name.
+ */
+#define PROFILE_COUNT(name, value) \
+    do { \
+        static const int profileCounter_ = Profiler::stageId(name, false); \
+        if (Profiler::isEnabled()) \
+            Profiler::record(profileCounter_, uint64(value)); \
+    } while (0)
+
+#endif
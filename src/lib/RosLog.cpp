@@ -0,0 +1,178 @@
+////////////////////////////////////////////////////////////////////
+// File includes:
+#include "RosLog.hpp"
+
+#include <cv_bridge/cv_bridge.h>
+
+void imageToRecord(const sensor_msgs::ImageConstPtr& msg, LogRecordType type, LogRecord& record)
+{
+    record = LogRecord();
+    record.type = type;
+    record.stamp = msg->header.stamp.toSec();
+    record.frame = msg->header.frame_id;
+    record.encoding = msg->encoding;
+    record.image = cv_bridge::toCvCopy(msg)->image; // the record outlives the message
+}
+
+sensor_msgs::ImagePtr recordToImage(const LogRecord& record)
+{
+    cv_bridge::CvImage image;
+    image.header.stamp = ros::Time(record.stamp);
+    image.header.frame_id = record.frame;
+    image.encoding = record.encoding;
+    image.image = record.image;
+    return image.toImageMsg();
+}
+
+void cameraInfoToRecord(const sensor_msgs::CameraInfo& msg, LogRecord& record)
+{
+    record = LogRecord();
+    record.type = LOG_CAMERA_INFO;
+    record.stamp = msg.header.stamp.toSec();
+    record.frame = msg.header.frame_id;
+    record.values.push_back(msg.width);
+    record.values.push_back(msg.height);
+    record.values.insert(record.values.end(), msg.K.begin(), msg.K.end());
+    record.values.insert(record.values.end(), msg.D.begin(), msg.D.end());
+}
+
+sensor_msgs::CameraInfoPtr recordToCameraInfo(const LogRecord& record)
+{
+    sensor_msgs::CameraInfoPtr msg(new sensor_msgs::CameraInfo());
+    msg->header.stamp = ros::Time(record.stamp);
+    msg->header.frame_id = record.frame;
+    if (record.values.size() < 11)
+        return msg;
+    msg->width = record.values[0];
+    msg->height = record.values[1];
+    std::copy(record.values.begin() + 2, record.values.begin() + 11, msg->K.begin());
+    msg->D.assign(record.values.begin() + 11, record.values.end());
+    return msg;
+}
+
+void mapToRecord(const nav_msgs::OccupancyGrid& msg, LogRecord& record)
+{
+    record = LogRecord();
+    record.type = LOG_MAP;
+    record.stamp = msg.header.stamp.toSec();
+    record.frame = msg.header.frame_id;
+    record.values.push_back(msg.info.width);
+    record.values.push_back(msg.info.height);
+    record.values.push_back(msg.info.resolution);
+    record.values.push_back(msg.info.origin.position.x);
+    record.values.push_back(msg.info.origin.position.y);
+    record.cells.assign(msg.data.begin(), msg.data.end());
+}
+
+nav_msgs::OccupancyGridPtr recordToMap(const LogRecord& record)
+{
+    nav_msgs::OccupancyGridPtr msg(new nav_msgs::OccupancyGrid());
+    msg->header.stamp = ros::Time(record.stamp);
+    msg->header.frame_id = record.frame;
+    if (record.values.size() < 5)
+        return msg;
+    msg->info.width = record.values[0];
+    msg->info.height = record.values[1];
+    msg->info.resolution = record.values[2];
+    msg->info.origin.position.x = record.values[3];
+    msg->info.origin.position.y = record.values[4];
+    msg->info.origin.orientation.w = 1;
+    msg->data.assign(record.cells.begin(), record.cells.end());
+    return msg;
+}
+
+void mapUpdateToRecord(const map_msgs::OccupancyGridUpdate& msg, LogRecord& record)
+{
+    record = LogRecord();
+    record.type = LOG_MAP_UPDATE;
+    record.stamp = msg.header.stamp.toSec();
+    record.frame = msg.header.frame_id;
+    record.values.push_back(msg.x);
+    record.values.push_back(msg.y);
+    record.values.push_back(msg.width);
+    record.values.push_back(msg.height);
+    record.cells.assign(msg.data.begin(), msg.data.end());
+}
+
+map_msgs::OccupancyGridUpdatePtr recordToMapUpdate(const LogRecord& record)
+{
+    map_msgs::OccupancyGridUpdatePtr msg(new map_msgs::OccupancyGridUpdate());
+    msg->header.stamp = ros::Time(record.stamp);
+    msg->header.frame_id = record.frame;
+    if (record.values.size() < 4)
+        return msg;
+    msg->x = record.values[0];
+    msg->y = record.values[1];
+    msg->width = record.values[2];
+    msg->height = record.values[3];
+    msg->data.assign(record.cells.begin(), record.cells.end());
+    return msg;
+}
+
+void transformToRecord(const tf::StampedTransform& transform, LogRecord& record)
+{
+    record = LogRecord();
+    record.type = LOG_TRANSFORM;
+    record.stamp = transform.stamp_.toSec();
+    record.frame = transform.frame_id_;
+    record.childFrame = transform.child_frame_id_;
+    const tf::Vector3& t = transform.getOrigin();
+    const tf::Quaternion q = transform.getRotation();
+    record.values.push_back(t.x());
+    record.values.push_back(t.y());
+    record.values.push_back(t.z());
+    record.values.push_back(q.x());
+    record.values.push_back(q.y());
+    record.values.push_back(q.z());
+    record.values.push_back(q.w());
+}
+
+tf::StampedTransform recordToTransform(const LogRecord& record)
+{
+    tf::Transform transform = tf::Transform::getIdentity();
+    if (record.values.size() >= 7) {
+        const std::vector<double>& v = record.values;
+        transform.setOrigin(tf::Vector3(v[0], v[1], v[2]));
+        transform.setRotation(tf::Quaternion(v[3], v[4], v[5], v[6]));
+    }
+    return tf::StampedTransform(transform, ros::Time(record.stamp), record.frame, record.childFrame);
+}
+
+MoveBaseStandIn::MoveBaseStandIn()
+: m_sent(0)
+, m_pending(false)
+{
+}
+
+void MoveBaseStandIn::sendGoal(const move_base_msgs::MoveBaseGoal&, DoneCallback done)
+{
+    // a new goal replaces the pending one, whose callback is never called
+    m_sent++;
+    m_pending = true;
+    m_done = done;
+}
+
+void MoveBaseStandIn::replay(const LogRecord& record)
+{
+    if (record.type == LOG_GOAL_SENT) {
+        const int order = m_recordedGoals.size() + 1;
+        m_recordedGoals.insert(std::make_pair(record.frame, order));
+        return;
+    }
+    if (record.type != LOG_GOAL_RESULT || record.values.empty())
+        return;
+
+    std::map<std::string, int>::const_iterator it = m_recordedGoals.find(record.frame);
+    if (!m_pending || it == m_recordedGoals.end() || it->second != m_sent)
+        return;
+
+    m_pending = false;
+    DoneCallback done = m_done;
+    done(actionlib::SimpleClientGoalState(
+             actionlib::SimpleClientGoalState::StateEnum(int(record.values[0]))));
+}
+
+int MoveBaseStandIn::goalsSent() const
+{
+    return m_sent;
+}
@@ -0,0 +1,70 @@
+#ifndef ROSLOG_HPP
+#define ROSLOG_HPP
+
+////////////////////////////////////////////////////////////////////
+// File includes:
+#include "SensorLog.hpp"
+
+#include <sensor_msgs/Image.h>
+#include <sensor_msgs/CameraInfo.h>
+#include <nav_msgs/OccupancyGrid.h>
+#include <map_msgs/OccupancyGridUpdate.h>
+#include <move_base_msgs/MoveBaseAction.h>
+#include <actionlib/client/simple_client_goal_state.h>
+#include <tf/transform_datatypes.h>
+
+#include <boost/function.hpp>
+
+#include <map>
+#include <string>
+
+/**
+ * Conversions between the ROS inputs of the node and the records of a SensorLog.
+ * The *ToRecord functions overwrite every field of @record.
+ */
+void imageToRecord(const sensor_msgs::ImageConstPtr& msg, LogRecordType type, LogRecord& record);
+sensor_msgs::ImagePtr recordToImage(const LogRecord& record);
+
+void cameraInfoToRecord(const sensor_msgs::CameraInfo& msg, LogRecord& record);
+sensor_msgs::CameraInfoPtr recordToCameraInfo(const LogRecord& record);
+
+void mapToRecord(const nav_msgs::OccupancyGrid& msg, LogRecord& record);
+nav_msgs::OccupancyGridPtr recordToMap(const LogRecord& record);
+
+void mapUpdateToRecord(const map_msgs::OccupancyGridUpdate& msg, LogRecord& record);
+map_msgs::OccupancyGridUpdatePtr recordToMapUpdate(const LogRecord& record);
+
+void transformToRecord(const tf::StampedTransform& transform, LogRecord& record);
+tf::StampedTransform recordToTransform(const LogRecord& record);
+
+/**
+ * Stand-in for the move_base action server during a replay.
+ * The n-th goal sent by the node is matched with the n-th goal of the recording, and it
+ * finishes when the recorded result of that goal is replayed, with the recorded state.
+ * Results of goals the node has not sent (or has replaced) are ignored, as the
+ * SimpleActionClient does.
+ */
+class MoveBaseStandIn
+{
+public:
+    typedef boost::function<void (const actionlib::SimpleClientGoalState&)> DoneCallback;
+
+    MoveBaseStandIn();
+
+    void sendGoal(const move_base_msgs::MoveBaseGoal& goal, DoneCallback done);
+
+    /**
+     * Feed a LOG_GOAL_SENT or LOG_GOAL_RESULT record.
+     */
+    void replay(const LogRecord& record);
+
+    int goalsSent() const;
+
+private:
+    std::map<std::string, int> m_recordedGoals; // recorded goal id -> order
+    int          m_sent;      // goals sent by the node
+    bool         m_pending;
+    DoneCallback m_done;
+};
+
+#endif
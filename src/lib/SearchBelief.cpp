@@ -0,0 +1,199 @@
+////////////////////////////////////////////////////////////////////
+// File includes:
+#include "SearchBelief.hpp"
+#include "TaskScheduler.hpp"
+
+////////////////////////////////////////////////////////////////////
+// Standard includes:
+#include <cmath>
+#include <algorithm>
+
+namespace
+{
+    class DetectionScore : public cv::ParallelLoopBody {
+        const SearchBelief& belief;
+        const ViewpointPlanner& sensor;
+        const cv::Mat& map;
+        const std::vector<cv::Point>& positions;
+        cv::Point robot;
+        double robotYaw;
+        const cv::Mat& travelCost;
+        std::vector<Viewpoint>& candidates;
+        std::vector<double>& detection;
+
+    public:
+        DetectionScore(const SearchBelief& belief, const ViewpointPlanner& sensor, const cv::Mat& map,
+                       const std::vector<cv::Point>& positions, cv::Point robot, double robotYaw,
+                       const cv::Mat& travelCost, std::vector<Viewpoint>& candidates, std::vector<double>& detection)
+            : belief(belief), sensor(sensor), map(map), positions(positions), robot(robot), robotYaw(robotYaw),
+              travelCost(travelCost), candidates(candidates), detection(detection) {}
+
+        void operator() (const cv::Range& range) const {
+            for (int i = range.start; i != range.end; i++) {
+                Viewpoint& vp = candidates[i];
+                vp.cell = positions[i / sensor.yawSamples];
+                vp.yaw = (i % sensor.yawSamples) * 2*CV_PI / sensor.yawSamples;
+                vp.gain = 0;
+
+                vp.time = sensor.travelTime(travelCost, robot, robotYaw, vp.cell, vp.yaw);
+                if (vp.time < 0) { // unreachable
+                    vp.time = 0;
+                    vp.score = -1;
+                    detection[i] = 0;
+                    continue;
+                }
+
+                detection[i] = belief.expectedDetection(map, sensor, vp.cell, vp.yaw);
+                vp.score = detection[i]/vp.time;
+            }
+        }
+    };
+}
+
+SearchBelief::SearchBelief()
+: detectionProb(0.3f)
+, detectionGain(20)
+, minWeight(1e-3f)
+, m_total(0)
+{
+}
+
+void SearchBelief::reset(cv::Size size)
+{
+    m_weight.create(size, CV_32F);
+    m_weight.setTo(1);
+    m_total = double(size.area());
+}
+
+bool SearchBelief::empty() const
+{
+    return m_weight.empty() || m_total <= 0;
+}
+
+void SearchBelief::ensureSize(const cv::Mat& map)
+{
+    if (m_weight.size() != map.size())
+        reset(map.size());
+}
+
+void SearchBelief::detectionMask(const cv::Mat& map, const ViewpointPlanner& sensor, cv::Point cell, double yaw,
+                                 cv::Mat& pd, cv::Rect& roi) const
+{
+    cv::Mat mask;
+    sensor.frustumMask(map, cell, yaw, mask, roi);
+
+    // pd = detectionProb*(1 - distance/range) on the visible cells, 0 elsewhere
+    pd = cv::Mat::zeros(roi.size(), CV_32F);
+    const float k = detectionProb/std::max(sensor.range, 1.0);
+    for (int y = 0; y < pd.rows; y++) {
+        const uchar* mrow = mask.ptr<uchar>(y);
+        float* row = pd.ptr<float>(y);
+        const float dy = float(roi.y + y - cell.y);
+        for (int x = 0; x < pd.cols; x++) {
+            if (mrow[x] == 0)
+                continue;
+            const float dx = float(roi.x + x - cell.x);
+            row[x] = std::max(detectionProb - k*std::sqrt(dx*dx + dy*dy), 0.f);
+        }
+    }
+}
+
+void SearchBelief::observe(const cv::Mat& map, const ViewpointPlanner& sensor, cv::Point cell, double yaw)
+{
+    ensureSize(map);
+
+    cv::Mat pd;
+    cv::Rect roi;
+    detectionMask(map, sensor, cell, yaw, pd, roi);
+    if (roi.area() == 0)
+        return;
+
+    // only the frustum changes, the total is corrected with the difference
+    cv::Mat w = m_weight(roi);
+    const double before = cv::sum(w)[0];
+    cv::Mat miss = 1 - pd;
+    cv::multiply(w, miss, w);
+    cv::max(w, minWeight, w);
+    m_total += cv::sum(w)[0] - before;
+}
+
+void SearchBelief::detect(cv::Point2f object, float sigma)
+{
+    if (m_weight.empty() || sigma <= 0)
+        return;
+
+    const int r = int(std::ceil(3*sigma));
+    const cv::Rect roi = cv::Rect(cvFloor(object.x) - r, cvFloor(object.y) - r, 2*r + 1, 2*r + 1)
+                       & cv::Rect(0, 0, m_weight.cols, m_weight.rows);
+    if (roi.area() == 0)
+        return;
+
+    cv::Mat w = m_weight(roi);
+    const double before = cv::sum(w)[0];
+    const float inv2s2 = 1.0f/(2*sigma*sigma);
+    for (int y = 0; y < w.rows; y++) {
+        float* row = w.ptr<float>(y);
+        const float dy = roi.y + y - object.y;
+        for (int x = 0; x < w.cols; x++) {
+            const float dx = roi.x + x - object.x;
+            row[x] *= 1 + detectionGain*std::exp(-(dx*dx + dy*dy)*inv2s2);
+        }
+    }
+    m_total += cv::sum(w)[0] - before;
+}
+
+double SearchBelief::expectedDetection(const cv::Mat& map, const ViewpointPlanner& sensor,
+                                       cv::Point cell, double yaw) const
+{
+    if (empty() || m_weight.size() != map.size())
+        return 0;
+
+    cv::Mat pd;
+    cv::Rect roi;
+    detectionMask(map, sensor, cell, yaw, pd, roi);
+    if (roi.area() == 0)
+        return 0;
+    return pd.dot(m_weight(roi))/m_total;
+}
+
+bool SearchBelief::selectBest(const cv::Mat& map, const ViewpointPlanner& sensor, const std::vector<cv::Point>& positions,
+                              cv::Point robot, double robotYaw, const cv::Mat& travelCost,
+                              Viewpoint& best, double minDetection) const
+{
+    if (positions.empty() || sensor.yawSamples <= 0 || empty())
+        return false;
+
+    std::vector<Viewpoint> candidates(positions.size()*sensor.yawSamples);
+    std::vector<double> detection(candidates.size());
+    TaskScheduler::parallelFor(cv::Range(0, candidates.size()),
+                               DetectionScore(*this, sensor, map, positions, robot, robotYaw, travelCost, candidates, detection));
+
+    int bestIdx = -1;
+    for (size_t i = 0; i < candidates.size(); i++) {
+        if (detection[i] < minDetection)
+            continue;
+        if (bestIdx < 0 || candidates[i].score > candidates[bestIdx].score)
+            bestIdx = i;
+    }
+    if (bestIdx < 0)
+        return false;
+
+    best = candidates[bestIdx];
+    return true;
+}
+
+float SearchBelief::probability(cv::Point cell) const
+{
+    if (empty() || !cv::Rect(0, 0, m_weight.cols, m_weight.rows).contains(cell))
+        return 0;
+    return float(m_weight.at<float>(cell)/m_total);
+}
+
+void SearchBelief::getProbability(cv::Mat& probability) const
+{
+    if (empty()) {
+        probability.release();
+        return;
+    }
+    m_weight.convertTo(probability, CV_32F, 1.0/m_total);
+}
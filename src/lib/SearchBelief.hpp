@@ -0,0 +1,75 @@
+#ifndef SEARCHBELIEF_HPP
+#define SEARCHBELIEF_HPP
+
+////////////////////////////////////////////////////////////////////
+// File includes:
+#include "ViewpointPlanner.hpp"
+
+#include <opencv2/opencv.hpp>
+
+#include <vector>
+
+/**
+ * Probability that the object is in each cell of the map.
+ * The grid holds unnormalized weights and their running total, so that an observation
+ * only touches the cells of the camera frustum: P(cell) = weight(cell)/total.
+ * Frustums come from a ViewpointPlanner (field of view, range and occlusions).
+ * Cells are (x = column, y = row).
+ */
+class SearchBelief
+{
+public:
+    SearchBelief();
+
+    /**
+     * Uniform belief over a map of @size. Called automatically when the map size changes.
+     */
+    void reset(cv::Size size);
+    bool empty() const;
+
+    /**
+     * Negative observation: the object was looked for from @cell/@yaw and not found.
+     * weight *= 1 - pd(distance) in the frustum, pd = detectionProb*(1 - distance/range).
+     */
+    void observe(const cv::Mat& map, const ViewpointPlanner& sensor, cv::Point cell, double yaw);
+
+    /**
+     * Detection at @object: weight *= 1 + detectionGain*exp(-d^2/(2 sigma^2)) around it.
+     */
+    void detect(cv::Point2f object, float sigma);
+
+    /**
+     * Probability of detecting the object from the pose: sum of pd*P over the frustum.
+     */
+    double expectedDetection(const cv::Mat& map, const ViewpointPlanner& sensor, cv::Point cell, double yaw) const;
+
+    /**
+     * Evaluate every position of @positions with sensor.yawSamples headings (in parallel) and
+     * return the one maximizing expected detection per unit of travel time (see ViewpointPlanner).
+     * Returns false if no candidate reaches @minDetection.
+     */
+    bool selectBest(const cv::Mat& map, const ViewpointPlanner& sensor, const std::vector<cv::Point>& positions,
+                    cv::Point robot, double robotYaw, const cv::Mat& travelCost,
+                    Viewpoint& best, double minDetection) const;
+
+    float probability(cv::Point cell) const;
+
+    /**
+     * CV_32F probabilities.
+     */
+    void getProbability(cv::Mat& probability) const;
+
+    float detectionProb;    // detection probability of one frame at zero distance
+    float detectionGain;    // weight increase at a detection
+    float minWeight;        // weights never go below this (missed detections happen), prior weight is 1
+
+private:
+    void ensureSize(const cv::Mat& map);
+    void detectionMask(const cv::Mat& map, const ViewpointPlanner& sensor, cv::Point cell, double yaw,
+                       cv::Mat& pd, cv::Rect& roi) const;
+
+    cv::Mat m_weight;       // CV_32F
+    double  m_total;        // sum of m_weight
+};
+
+#endif
@@ -0,0 +1,266 @@
+////////////////////////////////////////////////////////////////////
+// File includes:
+#include "SensorLog.hpp"
+
+////////////////////////////////////////////////////////////////////
+// Standard includes:
+#include <cstring>
+
+namespace
+{
+    const char     FILE_MAGIC[8] = { 'F', 'O', 'B', 'J', 'L', 'O', 'G', '1' };
+    const unsigned CHUNK_MAGIC = 0x4b4e4843; // "CHNK"
+
+    enum ImageFormat { IMAGE_NONE = 0, IMAGE_PNG = 1, IMAGE_RAW = 2 };
+
+    template <typename T>
+    void put(std::vector<uchar>& buf, const T& value)
+    {
+        const uchar* p = reinterpret_cast<const uchar*>(&value);
+        buf.insert(buf.end(), p, p + sizeof(T));
+    }
+
+    void putBytes(std::vector<uchar>& buf, const void* data, size_t size)
+    {
+        put(buf, unsigned(size));
+        const uchar* p = static_cast<const uchar*>(data);
+        buf.insert(buf.end(), p, p + size);
+    }
+
+    void putString(std::vector<uchar>& buf, const std::string& s)
+    {
+        putBytes(buf, s.data(), s.size());
+    }
+
+    // sequential reads from a chunk, failing past its end
+    struct ChunkReader
+    {
+        const std::vector<uchar>& buf;
+        size_t& offset;
+
+        ChunkReader(const std::vector<uchar>& buf, size_t& offset) : buf(buf), offset(offset) {}
+
+        bool bytes(void* out, size_t size)
+        {
+            if (offset + size > buf.size())
+                return false;
+            if (size)
+                std::memcpy(out, &buf[offset], size);
+            offset += size;
+            return true;
+        }
+
+        template <typename T>
+        bool get(T& value) { return bytes(&value, sizeof(T)); }
+
+        bool string(std::string& s)
+        {
+            unsigned size;
+            if (!get(size) || offset + size > buf.size())
+                return false;
+            s.assign(reinterpret_cast<const char*>(&buf[0]) + offset, size);
+            offset += size;
+            return true;
+        }
+    };
+}
+
+LogRecord::LogRecord()
+: type(LOG_RGB)
+, stamp(0)
+{
+}
+
+LogWriter::LogWriter()
+: pngCompression(1)
+, m_file(0)
+, m_chunkSize(0)
+, m_records(0)
+{
+}
+
+LogWriter::~LogWriter()
+{
+    close();
+}
+
+bool LogWriter::open(const std::string& file, size_t chunkSize)
+{
+    close();
+    m_file = std::fopen(file.c_str(), "wb");
+    if (!m_file)
+        return false;
+    std::fwrite(FILE_MAGIC, 1, sizeof(FILE_MAGIC), m_file);
+
+    m_chunkSize = chunkSize;
+    m_chunk.clear();
+    m_chunk.reserve(chunkSize + (1 << 20));
+    m_records = 0;
+    return true;
+}
+
+bool LogWriter::isOpen() const
+{
+    return m_file != 0;
+}
+
+void LogWriter::write(const LogRecord& r)
+{
+    if (!m_file)
+        return;
+
+    put(m_chunk, int(r.type));
+    put(m_chunk, r.stamp);
+    putString(m_chunk, r.frame);
+    putString(m_chunk, r.childFrame);
+    putString(m_chunk, r.encoding);
+
+    if (r.image.empty()) {
+        put(m_chunk, uchar(IMAGE_NONE));
+    } else if (r.image.depth() == CV_8U || r.image.depth() == CV_16U) {
+        std::vector<uchar> png;
+        std::vector<int> params(2);
+        params[0] = CV_IMWRITE_PNG_COMPRESSION;
+        params[1] = pngCompression;
+        cv::imencode(".png", r.image, png, params);
+        put(m_chunk, uchar(IMAGE_PNG));
+        putBytes(m_chunk, png.empty() ? 0 : &png[0], png.size());
+    } else {
+        const cv::Mat image = r.image.isContinuous() ? r.image : r.image.clone();
+        put(m_chunk, uchar(IMAGE_RAW));
+        put(m_chunk, image.rows);
+        put(m_chunk, image.cols);
+        put(m_chunk, image.type());
+        putBytes(m_chunk, image.data, image.total()*image.elemSize());
+    }
+
+    putBytes(m_chunk, r.values.empty() ? 0 : &r.values[0], r.values.size()*sizeof(double));
+    putBytes(m_chunk, r.cells.empty() ? 0 : &r.cells[0], r.cells.size());
+
+    m_records++;
+    if (m_chunk.size() >= m_chunkSize)
+        flush();
+}
+
+void LogWriter::flush()
+{
+    if (!m_file || m_records == 0)
+        return;
+
+    const unsigned header[3] = { CHUNK_MAGIC, m_records, unsigned(m_chunk.size()) };
+    std::fwrite(header, sizeof(header), 1, m_file);
+    std::fwrite(&m_chunk[0], 1, m_chunk.size(), m_file);
+    std::fflush(m_file);
+    m_chunk.clear();
+    m_records = 0;
+}
+
+void LogWriter::close()
+{
+    if (!m_file)
+        return;
+    flush();
+    std::fclose(m_file);
+    m_file = 0;
+}
+
+LogReader::LogReader()
+: m_file(0)
+, m_offset(0)
+, m_left(0)
+{
+}
+
+LogReader::~LogReader()
+{
+    close();
+}
+
+bool LogReader::open(const std::string& file)
+{
+    close();
+    m_file = std::fopen(file.c_str(), "rb");
+    if (!m_file)
+        return false;
+
+    char magic[sizeof(FILE_MAGIC)];
+    if (std::fread(magic, 1, sizeof(magic), m_file) != sizeof(magic) ||
+        std::memcmp(magic, FILE_MAGIC, sizeof(magic)) != 0) {
+        close();
+        return false;
+    }
+    m_left = 0;
+    return true;
+}
+
+void LogReader::close()
+{
+    if (m_file)
+        std::fclose(m_file);
+    m_file = 0;
+    m_chunk.clear();
+    m_left = 0;
+}
+
+bool LogReader::readChunk()
+{
+    unsigned header[3];
+    if (!m_file || std::fread(header, sizeof(header), 1, m_file) != 1 || header[0] != CHUNK_MAGIC)
+        return false;
+
+    m_chunk.resize(header[2]);
+    if (header[2] && std::fread(&m_chunk[0], 1, header[2], m_file) != header[2])
+        return false; // truncated: the last chunk is lost
+    m_offset = 0;
+    m_left = header[1];
+    return true;
+}
+
+bool LogReader::next(LogRecord& r)
+{
+    while (m_left == 0)
+        if (!readChunk())
+            return false;
+
+    ChunkReader in(m_chunk, m_offset);
+    int type;
+    uchar format;
+    if (!in.get(type) || !in.get(r.stamp) || !in.string(r.frame) || !in.string(r.childFrame) ||
+        !in.string(r.encoding) || !in.get(format))
+        return false;
+    r.type = LogRecordType(type);
+
+    r.image.release();
+    if (format == IMAGE_PNG) {
+        unsigned size;
+        if (!in.get(size) || m_offset + size > m_chunk.size())
+            return false;
+        const cv::Mat png(1, size, CV_8U, &m_chunk[m_offset]);
+        r.image = cv::imdecode(png, CV_LOAD_IMAGE_UNCHANGED);
+        m_offset += size;
+    } else if (format == IMAGE_RAW) {
+        int rows, cols, matType;
+        unsigned size;
+        if (!in.get(rows) || !in.get(cols) || !in.get(matType) || !in.get(size))
+            return false;
+        r.image.create(rows, cols, matType);
+        if (size != r.image.total()*r.image.elemSize() || !in.bytes(r.image.data, size))
+            return false;
+    }
+
+    unsigned size;
+    if (!in.get(size))
+        return false;
+    r.values.resize(size/sizeof(double));
+    if (!in.bytes(r.values.empty() ? 0 : &r.values[0], size))
+        return false;
+
+    if (!in.get(size))
+        return false;
+    r.cells.resize(size);
+    if (!in.bytes(r.cells.empty() ? 0 : &r.cells[0], size))
+        return false;
+
+    m_left--;
+    return true;
+}
@@ -0,0 +1,99 @@
+#ifndef SENSORLOG_HPP
+#define SENSORLOG_HPP
+
+////////////////////////////////////////////////////////////////////
+// File includes:
+#include <opencv2/opencv.hpp>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/**
+ * Kind of the inputs of the node kept in a log.
+ */
+enum LogRecordType
+{
+    LOG_RGB = 1,        // image, encoding
+    LOG_DEPTH,          // image, encoding
+    LOG_CAMERA_INFO,    // values: width, height, K (9), D (n)
+    LOG_MAP,            // values: width, height, resolution, origin x, origin y; cells
+    LOG_MAP_UPDATE,     // values: x, y, width, height; cells
+    LOG_TRANSFORM,      // frame -> childFrame, values: tx, ty, tz, qx, qy, qz, qw
+    LOG_GOAL_SENT,      // frame: goal id
+    LOG_GOAL_RESULT     // frame: goal id, values: actionlib SimpleClientGoalState
+};
+
+/**
+ * One timestamped input. Only the fields of its type are used.
+ */
+struct LogRecord
+{
+    LogRecord();
+
+    LogRecordType            type;
+    double                   stamp;      // seconds
+    std::string              frame;
+    std::string              childFrame;
+    std::string              encoding;
+    cv::Mat                  image;
+    std::vector<double>      values;
+    std::vector<signed char> cells;
+};
+
+/**
+ * Writes records into a file of independent chunks. Records are serialized into the current
+ * chunk in memory, which is written in one call once it exceeds the chunk size: recording
+ * costs one write per chunk, and a truncated file loses at most its last chunk.
+ * 8 and 16 bits images are stored as PNG (lossless), others raw.
+ */
+class LogWriter
+{
+public:
+    LogWriter();
+    ~LogWriter();
+
+    bool open(const std::string& file, size_t chunkSize = 4 << 20);
+    void write(const LogRecord& record);
+    void close();
+    bool isOpen() const;
+
+    // PNG compression level, 1 is fast enough to record a camera at full rate
+    int pngCompression;
+
+private:
+    void flush();
+
+    std::FILE*         m_file;
+    size_t             m_chunkSize;
+    std::vector<uchar> m_chunk;
+    unsigned           m_records;
+};
+
+/**
+ * Reads the records of a log in the order they were written.
+ */
+class LogReader
+{
+public:
+    LogReader();
+    ~LogReader();
+
+    bool open(const std::string& file);
+
+    /**
+     * False at the end of the log (or of its last complete chunk).
+     */
+    bool next(LogRecord& record);
+    void close();
+
+private:
+    bool readChunk();
+
+    std::FILE*         m_file;
+    std::vector<uchar> m_chunk;
+    size_t             m_offset;
+    unsigned           m_left;    // records left in the chunk
+};
+
+#endif
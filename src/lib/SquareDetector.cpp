@@ -0,0 +1,110 @@
+////////////////////////////////////////////////////////////////////
+// File includes:
+#include "SquareDetector.hpp"
+#include "Profiler.hpp"
+
+////////////////////////////////////////////////////////////////////
+// Standard includes:
+#include <cmath>
+#include <algorithm>
+
+namespace
+{
+    // cosine of the angle between pt0->pt1 and pt0->pt2
+    double angle(cv::Point pt1, cv::Point pt2, cv::Point pt0)
+    {
+        double dx1 = pt1.x - pt0.x;
+        double dy1 = pt1.y - pt0.y;
+        double dx2 = pt2.x - pt0.x;
+        double dy2 = pt2.y - pt0.y;
+        return (dx1*dx2 + dy1*dy2)/std::sqrt((dx1*dx1 + dy1*dy1)*(dx2*dx2 + dy2*dy2) + 1e-10);
+    }
+
+    // squared distance
+    double distance(cv::Point pt1, cv::Point pt2)
+    {
+        double dx = pt1.x - pt2.x;
+        double dy = pt1.y - pt2.y;
+        return dx*dx + dy*dy;
+    }
+}
+
+void findSquares(const cv::Mat& bgr, std::vector<std::vector<cv::Point> >& squares)
+{
+    squares.clear();
+
+    cv::Mat gray;
+    cv::cvtColor(bgr, gray, CV_BGR2GRAY);
+
+    cv::Mat thresh;
+    cv::adaptiveThreshold(gray, thresh, 255, cv::ADAPTIVE_THRESH_MEAN_C,
+                          cv::THRESH_BINARY_INV, 3, 10);
+
+    std::vector<std::vector<cv::Point> > contours;
+    cv::findContours(thresh, contours, cv::RETR_LIST, cv::CHAIN_APPROX_SIMPLE);
+
+    std::vector<cv::Point> approx;
+    for (size_t i = 0; i < contours.size(); i++) {
+        cv::approxPolyDP(cv::Mat(contours[i]), approx, cv::arcLength(cv::Mat(contours[i]), true)*0.02, true);
+        if (approx.size() != 4)
+            continue;
+
+        const double area = std::fabs(cv::contourArea(cv::Mat(approx)));
+        if (area <= 150 || area >= 22000 || !cv::isContourConvex(cv::Mat(approx)))
+            continue;
+
+        double maxCosine = 0;
+        for (int j = 2; j < 5; j++) {
+            double cosine = std::fabs(angle(approx[j%4], approx[j-2], approx[j-1]));
+            maxCosine = std::max(maxCosine, cosine);
+        }
+        double edgeratio = (distance(approx[0], approx[1]) + distance(approx[2], approx[3]))
+                           /(distance(approx[1], approx[2]) + distance(approx[3], approx[0]));
+
+        if (maxCosine < 0.25 && edgeratio > 0.35 && edgeratio < 1.65)
+            squares.push_back(approx);
+    }
+}
+
+cv::Rect squareBoundingBox(const std::vector<cv::Point>& square)
+{
+    cv::Point ini(10000, 10000), end(0, 0);
+    for (size_t j = 0; j < square.size(); j++) {
+        ini.x = std::min(ini.x, square[j].x);
+        ini.y = std::min(ini.y, square[j].y);
+        end.x = std::max(end.x, square[j].x);
+        end.y = std::max(end.y, square[j].y);
+    }
+    return cv::Rect(ini, end);
+}
+
+std::vector<cv::Point> selectSquare(const std::vector<std::vector<cv::Point> >& squares, const cv::Mat& bgr,
+                                    const HistogramVerifier& verifier)
+{
+    std::vector<cv::Point> out;
+    if (squares.empty() || !verifier.hasTemplate())
+        return out;
+
+    std::vector<cv::Rect> boxes(squares.size());
+    for (size_t i = 0; i < squares.size(); i++)
+        boxes[i] = squareBoundingBox(squares[i]);
+
+    std::vector<float> distances;
+    {
+        PROFILE_SCOPE("detectObject.histogram");
+        verifier.score(bgr, boxes, distances);
+    }
+
+    float maxd = 0;
+    size_t maxi = 0;
+    for (size_t i = 0; i < squares.size(); i++) {
+        if (distances[i] > maxd) {
+            maxd = distances[i];
+            maxi = i;
+        }
+    }
+    // too dissimilar, eliminate
+    if (distances[maxi] > 0.375)
+        return out;
+    return squares[maxi];
+}
@@ -0,0 +1,32 @@
+#ifndef SQUAREDETECTOR_HPP
+#define SQUAREDETECTOR_HPP
+
+////////////////////////////////////////////////////////////////////
+// File includes:
+#include "HistogramVerifier.hpp"
+
+#include <opencv2/opencv.hpp>
+
+#include <vector>
+
+/**
+ * Find the convex quadrilaterals of a BGR image that look like the face of the object:
+ * contours of the adaptive threshold approximated by 4 corners, with an area between
+ * 150 and 22000 pixels, nearly right angles and opposite edges of similar length.
+ */
+void findSquares(const cv::Mat& bgr, std::vector<std::vector<cv::Point> >& squares);
+
+/**
+ * Bounding box of the corners of a square, from its top-left to its bottom-right corner.
+ */
+cv::Rect squareBoundingBox(const std::vector<cv::Point>& square);
+
+/**
+ * Pick among @squares the candidate selected by the histogram comparison of its bounding box
+ * with the template of @verifier. Returns an empty contour when there is no candidate,
+ * no template, or the selected candidate is too different from the template.
+ */
+std::vector<cv::Point> selectSquare(const std::vector<std::vector<cv::Point> >& squares, const cv::Mat& bgr,
+                                    const HistogramVerifier& verifier);
+
+#endif
@@ -0,0 +1,212 @@
+////////////////////////////////////////////////////////////////////
+// File includes:
+#include "SyntheticScene.hpp"
+#include "TaskScheduler.hpp"
+
+////////////////////////////////////////////////////////////////////
+// Standard includes:
+#include <cmath>
+#include <cfloat>
+#include <cstdio>
+#include <algorithm>
+
+namespace
+{
+    class RenderBody : public cv::ParallelLoopBody {
+        const SceneGenerator& generator;
+        std::vector<SyntheticSample>& samples;
+
+    public:
+        RenderBody(const SceneGenerator& generator, std::vector<SyntheticSample>& samples)
+            : generator(generator), samples(samples) {}
+
+        void operator() (const cv::Range& range) const {
+            for (int i = range.start; i != range.end; i++)
+                generator.render(i, samples[i]);
+        }
+    };
+
+    std::string samplePath(const std::string& dir, int index, const char* extension)
+    {
+        char name[32];
+        std::snprintf(name, sizeof(name), "/%06d.%s", index, extension);
+        return dir + name;
+    }
+}
+
+SceneParams::SceneParams()
+: frameSize(640, 480)
+, minScale(0.15f), maxScale(0.6f)
+, maxRotation(float(CV_PI/6))
+, perspective(0.2f)
+, maxBlur(2.0f)
+, maxNoise(8.0f)
+, minGain(0.5f), maxGain(1.3f)
+, maxBias(30.0f)
+, occlusionProb(0.3f)
+, maxOcclusion(0.35f)
+{
+}
+
+SceneGenerator::SceneGenerator(const std::vector<cv::Mat>& templates, const std::vector<cv::Mat>& backgrounds,
+                               const SceneParams& params, uint64 seed)
+: m_templates(templates)
+, m_backgrounds(backgrounds)
+, m_params(params)
+, m_seed(seed)
+{
+    CV_Assert(!m_templates.empty());
+}
+
+const SceneParams& SceneGenerator::params() const
+{
+    return m_params;
+}
+
+void SceneGenerator::background(cv::RNG& rng, cv::Mat& frame) const
+{
+    const cv::Size size = m_params.frameSize;
+    if (!m_backgrounds.empty()) {
+        // random crop of at least half of a random background, resized to the frame
+        const cv::Mat& bg = m_backgrounds[rng.uniform(0, (int)m_backgrounds.size())];
+        const float f = rng.uniform(0.5f, 1.0f);
+        const cv::Size crop(std::max(1, int(f*bg.cols)), std::max(1, int(f*bg.rows)));
+        const cv::Rect r(rng.uniform(0, bg.cols - crop.width + 1), rng.uniform(0, bg.rows - crop.height + 1),
+                         crop.width, crop.height);
+        cv::resize(bg(r), frame, size, 0, 0, cv::INTER_AREA);
+        if (frame.channels() == 1)
+            cv::cvtColor(frame, frame, CV_GRAY2BGR);
+        return;
+    }
+
+    // procedural clutter: smooth noise and a few rectangles with corners for the detectors
+    frame.create(size, CV_8UC3);
+    rng.fill(frame, cv::RNG::UNIFORM, cv::Scalar::all(40), cv::Scalar::all(220));
+    cv::GaussianBlur(frame, frame, cv::Size(0, 0), 6);
+    for (int k = 0; k < 12; k++) {
+        const cv::Point a(rng.uniform(0, size.width), rng.uniform(0, size.height));
+        const cv::Point b = a + cv::Point(rng.uniform(-80, 80), rng.uniform(-80, 80));
+        cv::rectangle(frame, a, b, cv::Scalar(rng.uniform(0, 256), rng.uniform(0, 256), rng.uniform(0, 256)), CV_FILLED);
+    }
+}
+
+void SceneGenerator::render(int index, SyntheticSample& sample) const
+{
+    cv::RNG rng(m_seed*0x9E3779B97F4A7C15ULL + uint64(index) + 1);
+    const SceneParams& p = m_params;
+
+    background(rng, sample.image);
+
+    sample.patternIdx = rng.uniform(0, (int)m_templates.size());
+    const cv::Mat& templ = m_templates[sample.patternIdx];
+
+    // template corners, centered, scaled, rotated and jittered
+    sample.scale = rng.uniform(p.minScale, p.maxScale);
+    const float s = sample.scale*p.frameSize.width/std::max(templ.cols, templ.rows);
+    const float angle = rng.uniform(-p.maxRotation, p.maxRotation);
+    const float ca = std::cos(angle), sa = std::sin(angle);
+    const float jitter = p.perspective*s*std::min(templ.cols, templ.rows);
+
+    cv::Point2f src[4] = { cv::Point2f(0, 0), cv::Point2f(templ.cols, 0),
+                           cv::Point2f(templ.cols, templ.rows), cv::Point2f(0, templ.rows) };
+    cv::Point2f dst[4];
+    cv::Point2f lo(FLT_MAX, FLT_MAX), hi(-FLT_MAX, -FLT_MAX);
+    for (int k = 0; k < 4; k++) {
+        const cv::Point2f c = s*(src[k] - cv::Point2f(0.5f*templ.cols, 0.5f*templ.rows));
+        dst[k] = cv::Point2f(ca*c.x - sa*c.y, sa*c.x + ca*c.y)
+               + cv::Point2f(rng.uniform(-jitter, jitter), rng.uniform(-jitter, jitter));
+        lo = cv::Point2f(std::min(lo.x, dst[k].x), std::min(lo.y, dst[k].y));
+        hi = cv::Point2f(std::max(hi.x, dst[k].x), std::max(hi.y, dst[k].y));
+    }
+
+    // random position keeping the whole template in the frame (centered when it is too large)
+    const float W = p.frameSize.width - 1, H = p.frameSize.height - 1;
+    const cv::Point2f offset((hi.x - lo.x < W) ? rng.uniform(-lo.x, W - hi.x) : 0.5f*W - 0.5f*(lo.x + hi.x),
+                             (hi.y - lo.y < H) ? rng.uniform(-lo.y, H - hi.y) : 0.5f*H - 0.5f*(lo.y + hi.y));
+    for (int k = 0; k < 4; k++)
+        dst[k] += offset;
+
+    sample.homography = cv::getPerspectiveTransform(src, dst);
+    sample.corners.assign(dst, dst + 4);
+
+    // illumination, then warp on top of the background
+    sample.gain = rng.uniform(p.minGain, p.maxGain);
+    cv::Mat lit;
+    templ.convertTo(lit, CV_8U, sample.gain, rng.uniform(-p.maxBias, p.maxBias));
+    if (lit.channels() == 1)
+        cv::cvtColor(lit, lit, CV_GRAY2BGR);
+    cv::warpPerspective(lit, sample.image, sample.homography, sample.image.size(),
+                        cv::INTER_LINEAR, cv::BORDER_TRANSPARENT);
+
+    // occluder: a flat rectangle over part of the template bounding box
+    sample.occlusion = 0;
+    const cv::Rect box = cv::Rect(cv::Point(lo + offset), cv::Point(hi + offset))
+                       & cv::Rect(0, 0, p.frameSize.width, p.frameSize.height);
+    if (box.area() > 0 && rng.uniform(0.f, 1.f) < p.occlusionProb) {
+        const float fraction = rng.uniform(0.f, p.maxOcclusion);
+        const float aspect = rng.uniform(0.5f, 2.0f);
+        const int w = std::min(box.width, std::max(1, int(std::sqrt(fraction*box.area()*aspect))));
+        const int h = std::min(box.height, std::max(1, int(fraction*box.area()/w)));
+        const cv::Rect occluder(box.x + rng.uniform(0, box.width - w + 1), box.y + rng.uniform(0, box.height - h + 1), w, h);
+        sample.image(occluder).setTo(cv::Scalar(rng.uniform(0, 256), rng.uniform(0, 256), rng.uniform(0, 256)));
+        sample.occlusion = float(occluder.area())/box.area();
+    }
+
+    // camera: defocus then sensor noise
+    sample.blur = rng.uniform(0.f, p.maxBlur);
+    if (sample.blur > 0.3f)
+        cv::GaussianBlur(sample.image, sample.image, cv::Size(0, 0), sample.blur);
+
+    sample.noise = rng.uniform(0.f, p.maxNoise);
+    if (sample.noise > 0) {
+        cv::Mat noise(sample.image.size(), CV_16SC3);
+        rng.fill(noise, cv::RNG::NORMAL, cv::Scalar::all(0), cv::Scalar::all(sample.noise));
+        cv::Mat noisy;
+        sample.image.convertTo(noisy, CV_16SC3);
+        noisy += noise;
+        noisy.convertTo(sample.image, CV_8UC3);
+    }
+}
+
+void SceneGenerator::renderAll(int count, std::vector<SyntheticSample>& samples) const
+{
+    samples.resize(count);
+    TaskScheduler::parallelFor(cv::Range(0, count), RenderBody(*this, samples));
+}
+
+bool saveSample(const std::string& dir, int index, const SyntheticSample& sample)
+{
+    if (!cv::imwrite(samplePath(dir, index, "png"), sample.image))
+        return false;
+
+    cv::FileStorage fs(samplePath(dir, index, "yml"), cv::FileStorage::WRITE);
+    if (!fs.isOpened())
+        return false;
+    fs << "patternIdx" << sample.patternIdx
+       << "homography" << sample.homography
+       << "corners" << sample.corners
+       << "scale" << sample.scale << "blur" << sample.blur << "noise" << sample.noise
+       << "gain" << sample.gain << "occlusion" << sample.occlusion;
+    return true;
+}
+
+bool loadSample(const std::string& dir, int index, SyntheticSample& sample)
+{
+    cv::FileStorage fs(samplePath(dir, index, "yml"), cv::FileStorage::READ);
+    if (!fs.isOpened())
+        return false;
+
+    sample.image = cv::imread(samplePath(dir, index, "png"));
+    if (sample.image.empty())
+        return false;
+
+    fs["patternIdx"] >> sample.patternIdx;
+    fs["homography"] >> sample.homography;
+    fs["corners"] >> sample.corners;
+    fs["scale"] >> sample.scale;
+    fs["blur"] >> sample.blur;
+    fs["noise"] >> sample.noise;
+    fs["gain"] >> sample.gain;
+    fs["occlusion"] >> sample.occlusion;
+    return sample.corners.size() == 4;
+}
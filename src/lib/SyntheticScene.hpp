@@ -0,0 +1,85 @@
+#ifndef SYNTHETICSCENE_HPP
+#define SYNTHETICSCENE_HPP
+
+////////////////////////////////////////////////////////////////////
+// File includes:
+#include <opencv2/opencv.hpp>
+
+#include <string>
+#include <vector>
+
+/**
+ * Rendered frame with its exact ground truth.
+ */
+struct SyntheticSample
+{
+    cv::Mat                  image;         // BGR
+    int                      patternIdx;    // template rendered in the frame
+    cv::Mat                  homography;    // template to frame, CV_64F
+    std::vector<cv::Point2f> corners;       // template corners in the frame (tl, tr, br, bl)
+
+    // rendering conditions, for breaking results down
+    float                    scale;         // longest template side / frame width
+    float                    blur;          // gaussian sigma, pixels
+    float                    noise;         // gaussian sigma, gray levels
+    float                    gain;          // illumination gain of the template
+    float                    occlusion;     // occluded fraction of the template bounding box
+};
+
+/**
+ * Ranges the rendering conditions are drawn from (uniformly).
+ */
+struct SceneParams
+{
+    SceneParams();
+
+    cv::Size frameSize;
+    float    minScale, maxScale;    // longest template side / frame width
+    float    maxRotation;           // in-plane, radians
+    float    perspective;           // corner jitter, fraction of the template size
+    float    maxBlur;               // sigma
+    float    maxNoise;              // sigma
+    float    minGain, maxGain;      // template intensity gain
+    float    maxBias;               // template intensity offset
+    float    occlusionProb;         // probability of an occluder
+    float    maxOcclusion;          // largest occluded fraction of the template bounding box
+};
+
+/**
+ * Renders the template images under random homographies, scale, blur, noise, illumination
+ * and partial occlusion onto background images (or procedural texture when there is none).
+ * Sample @index only depends on the seed and on @index, so samples can be rendered in parallel
+ * and a dataset is reproduced exactly from its seed.
+ */
+class SceneGenerator
+{
+public:
+    SceneGenerator(const std::vector<cv::Mat>& templates, const std::vector<cv::Mat>& backgrounds,
+                   const SceneParams& params = SceneParams(), uint64 seed = 1);
+
+    void render(int index, SyntheticSample& sample) const;
+
+    /**
+     * Render samples [0, @count) in parallel.
+     */
+    void renderAll(int count, std::vector<SyntheticSample>& samples) const;
+
+    const SceneParams& params() const;
+
+private:
+    void background(cv::RNG& rng, cv::Mat& frame) const;
+
+    std::vector<cv::Mat> m_templates;
+    std::vector<cv::Mat> m_backgrounds;
+    SceneParams          m_params;
+    uint64               m_seed;
+};
+
+/**
+ * Dataset files: <dir>/<index>.png and the ground truth in <dir>/<index>.yml
+ * (cv::FileStorage). The directory must exist.
+ */
+bool saveSample(const std::string& dir, int index, const SyntheticSample& sample);
+bool loadSample(const std::string& dir, int index, SyntheticSample& sample);
+
+#endif
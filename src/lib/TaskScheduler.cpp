@@ -0,0 +1,285 @@
+////////////////////////////////////////////////////////////////////
+// File includes:
+#include "TaskScheduler.hpp"
+
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+////////////////////////////////////////////////////////////////////
+// Standard includes:
+#include <pthread.h>
+#include <sched.h>
+#include <deque>
+#include <vector>
+#include <algorithm>
+#include <exception>
+
+namespace
+{
+    struct TaskGroup
+    {
+        volatile int  pending;  // tasks of the range not finished yet
+        boost::mutex  mutex;
+        bool          failed;
+        cv::Exception error;
+
+        TaskGroup() : pending(1), failed(false) {}
+    };
+
+    struct Task
+    {
+        const cv::ParallelLoopBody* body;
+        cv::Range  range;
+        int        grain;
+        TaskGroup* group;
+    };
+
+    // owner pushes and pops at the back, thieves take the oldest (largest) tasks at the front
+    struct WorkQueue
+    {
+        boost::mutex     mutex;
+        std::deque<Task> tasks;
+    };
+
+    // The pool state is allocated once and never destroyed: the workers are not joined at
+    // exit, they still sleep on the condition (or read the queues) while the static objects
+    // are destroyed, and destroying a condition with waiters blocks forever.
+
+    // one queue per worker, then one shared by the threads that are not workers
+    std::vector<WorkQueue*>& queues = *new std::vector<WorkQueue*>();
+    std::vector<boost::thread*>& threads = *new std::vector<boost::thread*>();
+    boost::mutex& poolMutex = *new boost::mutex();
+    volatile bool started = false;
+    volatile bool stopping = false;
+
+    // idle workers and waiting callers sleep until a task is pushed or a group is done:
+    // the epoch changes on both
+    boost::mutex& sleepMutex = *new boost::mutex();
+    boost::condition_variable& wake = *new boost::condition_variable();
+    int sleeping = 0;
+    volatile int epoch = 0;
+
+    __thread int workerIndex = -1;
+
+    // full barrier read: what the tasks wrote is visible once their count is seen
+    inline int load(volatile int& value)
+    {
+        return __sync_add_and_fetch(&value, 0);
+    }
+
+    int ownQueue()
+    {
+        return workerIndex >= 0 ? workerIndex : int(queues.size()) - 1;
+    }
+
+    void push(int q, const Task& task)
+    {
+        {
+            boost::mutex::scoped_lock lock(queues[q]->mutex);
+            queues[q]->tasks.push_back(task);
+        }
+        __sync_fetch_and_add(&epoch, 1);
+        boost::mutex::scoped_lock lock(sleepMutex);
+        if (sleeping > 0)
+            wake.notify_one();
+    }
+
+    bool popBack(int q, Task& task)
+    {
+        boost::mutex::scoped_lock lock(queues[q]->mutex);
+        if (queues[q]->tasks.empty())
+            return false;
+        task = queues[q]->tasks.back();
+        queues[q]->tasks.pop_back();
+        return true;
+    }
+
+    bool popFront(int q, Task& task)
+    {
+        boost::mutex::scoped_lock lock(queues[q]->mutex);
+        if (queues[q]->tasks.empty())
+            return false;
+        task = queues[q]->tasks.front();
+        queues[q]->tasks.pop_front();
+        return true;
+    }
+
+    bool findTask(int self, Task& task)
+    {
+        if (popBack(self, task))
+            return true;
+        const int n = queues.size();
+        for (int k = 1; k < n; k++)
+            if (popFront((self + k) % n, task))
+                return true;
+        return false;
+    }
+
+    void fail(TaskGroup& group, const cv::Exception& e)
+    {
+        boost::mutex::scoped_lock lock(group.mutex);
+        if (!group.failed) {
+            group.failed = true;
+            group.error = e;
+        }
+    }
+
+    void execute(int self, Task task)
+    {
+        // keep the first half, leave the others to be stolen
+        while (task.range.end - task.range.start > task.grain) {
+            Task right = task;
+            right.range.start = task.range.start + (task.range.end - task.range.start)/2;
+            task.range.end = right.range.start;
+            __sync_fetch_and_add(&task.group->pending, 1);
+            push(self, right);
+        }
+
+        try {
+            (*task.body)(task.range);
+        } catch (const cv::Exception& e) {
+            fail(*task.group, e);
+        } catch (const std::exception& e) {
+            fail(*task.group, cv::Exception(CV_StsError, e.what(), "TaskScheduler::parallelFor", __FILE__, __LINE__));
+        }
+        // last access to the group: the waiter may destroy it right after
+        if (__sync_sub_and_fetch(&task.group->pending, 1) == 0) {
+            // wake the waiter if it went to sleep (and the idle workers, they sleep again)
+            __sync_fetch_and_add(&epoch, 1);
+            boost::mutex::scoped_lock lock(sleepMutex);
+            if (sleeping > 0)
+                wake.notify_all();
+        }
+    }
+
+    void workerLoop(int index, int cpu)
+    {
+        workerIndex = index;
+        if (cpu >= 0) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+            pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        }
+
+        for (;;) {
+            const int seen = load(epoch);
+            Task task;
+            if (findTask(index, task)) {
+                execute(index, task);
+                continue;
+            }
+
+            // stopping is set under the lock, when no task is left
+            boost::mutex::scoped_lock lock(sleepMutex);
+            if (stopping)
+                break;
+            if (load(epoch) != seen)
+                continue;
+            sleeping++;
+            wake.wait(lock);
+            sleeping--;
+        }
+    }
+
+    void stopPool()
+    {
+        {
+            boost::mutex::scoped_lock lock(sleepMutex);
+            stopping = true;
+            wake.notify_all();
+        }
+        for (size_t i = 0; i < threads.size(); i++) {
+            threads[i]->join();
+            delete threads[i];
+        }
+        threads.clear();
+        for (size_t i = 0; i < queues.size(); i++)
+            delete queues[i];
+        queues.clear();
+        stopping = false;
+        started = false;
+    }
+
+    void startPool(int workers, bool affinity)
+    {
+        if (started)
+            stopPool();
+        if (workers < 0)
+            workers = std::max(cv::getNumberOfCPUs() - 1, 0);
+
+        for (int i = 0; i <= workers; i++)
+            queues.push_back(new WorkQueue());
+        const int cpus = cv::getNumberOfCPUs();
+        for (int i = 0; i < workers; i++)
+            threads.push_back(new boost::thread(workerLoop, i, affinity ? (i + 1) % cpus : -1));
+        __sync_synchronize();
+        started = true;
+    }
+}
+
+void TaskScheduler::init(int workers, bool affinity)
+{
+    boost::mutex::scoped_lock lock(poolMutex);
+    startPool(workers, affinity);
+}
+
+void TaskScheduler::shutdown()
+{
+    boost::mutex::scoped_lock lock(poolMutex);
+    if (started)
+        stopPool();
+}
+
+int TaskScheduler::workers()
+{
+    return threads.size();
+}
+
+void TaskScheduler::parallelFor(const cv::Range& range, const cv::ParallelLoopBody& body, int grain)
+{
+    if (range.end <= range.start)
+        return;
+    if (!started) {
+        boost::mutex::scoped_lock lock(poolMutex);
+        if (!started)
+            startPool(-1, false);
+    }
+    grain = std::max(grain, 1);
+    if (threads.empty() || range.end - range.start <= grain) {
+        body(range);
+        return;
+    }
+
+    TaskGroup group;
+    Task root;
+    root.body = &body;
+    root.range = range;
+    root.grain = grain;
+    root.group = &group;
+
+    const int self = ownQueue();
+    execute(self, root);
+
+    // help with whatever is pending until the other chunks of the range are done, sleep when
+    // there is nothing to take: a push or the end of the group changes the epoch
+    while (load(group.pending) > 0) {
+        const int seen = load(epoch);
+        Task task;
+        if (findTask(self, task)) {
+            execute(self, task);
+            continue;
+        }
+
+        boost::mutex::scoped_lock lock(sleepMutex);
+        if (load(group.pending) == 0 || load(epoch) != seen)
+            continue;
+        sleeping++;
+        wake.wait(lock);
+        sleeping--;
+    }
+
+    if (group.failed)
+        throw group.error;
+}
@@ -0,0 +1,46 @@
+#ifndef TASKSCHEDULER_HPP
+#define TASKSCHEDULER_HPP
+
+////////////////////////////////////////////////////////////////////
+// File includes:
+#include <opencv2/core/core.hpp>
+
+/**
+ * Process-wide pool of worker threads with work stealing, shared by every parallel stage
+ * (pattern matching, histogram checks, feature extraction tiles, planners, batches).
+ * parallelFor() splits its range in halves down to @grain; the halves go to the deque of the
+ * calling thread, where idle workers steal them. The caller runs its own part and then other
+ * pending tasks until its range is done, and only sleeps when there is nothing left to take,
+ * so a parallelFor nested in a task runs on the same threads instead of adding more, and
+ * cannot deadlock.
+ * State a task keeps per thread must tolerate that re-entrance (keep it per call instead).
+ */
+class TaskScheduler
+{
+public:
+    /**
+     * (Re)start the pool with @workers threads besides the callers, -1 for one per CPU
+     * minus one, 0 to run everything serially in the caller. With @affinity each worker is
+     * pinned to its own CPU. Must not be called while tasks are running.
+     * parallelFor() starts a default pool (-1, no affinity) when init() was not called.
+     */
+    static void init(int workers = -1, bool affinity = false);
+
+    /**
+     * Stop and join the workers. Optional before exit: the pool is never destroyed, running
+     * workers do not hold the process.
+     */
+    static void shutdown();
+
+    static int workers();
+
+    /**
+     * Run @body over @range, in parallel in chunks of at least @grain iterations.
+     * Returns when the whole range is done. An exception thrown by the body is rethrown here
+     * once the other chunks are done (the first one; when it ran on the pool, other
+     * exceptions than cv::Exception come back as cv::Exception).
+     */
+    static void parallelFor(const cv::Range& range, const cv::ParallelLoopBody& body, int grain = 1);
+};
+
+#endif
@@ -0,0 +1,152 @@
+////////////////////////////////////////////////////////////////////
+// File includes:
+#include "Tracer.hpp"
+
+////////////////////////////////////////////////////////////////////
+// Standard includes:
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <csignal>
+#include <cstdio>
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+    struct TraceEvent
+    {
+        const char* name;   // 0 while the slot is being written
+        char        phase;  // 'B', 'E' or 'i'
+        int         tid;
+        int64       ticks;
+        int64       frame;
+    };
+
+    std::vector<TraceEvent> events;
+    volatile size_t next = 0;   // total number of events recorded
+    volatile bool enabled = false;
+    volatile int64 currentFrame = 0;
+    volatile std::sig_atomic_t dumpRequested = 0;
+
+    __thread int cachedTid = 0;
+
+    int threadId()
+    {
+        if (cachedTid == 0)
+            cachedTid = int(syscall(SYS_gettid));
+        return cachedTid;
+    }
+
+    void record(const char* name, char phase)
+    {
+        const int64 ticks = cv::getTickCount();
+        const size_t idx = __sync_fetch_and_add(&next, 1) % events.size();
+        TraceEvent& e = events[idx];
+        e.name = 0;
+        e.phase = phase;
+        e.tid = threadId();
+        e.ticks = ticks;
+        e.frame = currentFrame;
+        __sync_synchronize();
+        e.name = name;
+    }
+
+    // JSON string contents: names are literals, only quotes and backslashes need care
+    void writeName(FILE* f, const char* name)
+    {
+        for (const char* c = name; *c; c++) {
+            if (*c == '"' || *c == '\\')
+                std::fputc('\\', f);
+            std::fputc(*c, f);
+        }
+    }
+}
+
+void Tracer::init(size_t capacity)
+{
+    enabled = false;
+    events.assign(std::max(capacity, size_t(1)), TraceEvent());
+    for (size_t i = 0; i < events.size(); i++)
+        events[i].name = 0;
+    next = 0;
+    enabled = true;
+}
+
+bool Tracer::isEnabled()
+{
+    return enabled;
+}
+
+void Tracer::begin(const char* name)
+{
+    if (enabled)
+        record(name, 'B');
+}
+
+void Tracer::end(const char* name)
+{
+    if (enabled)
+        record(name, 'E');
+}
+
+void Tracer::instant(const char* name)
+{
+    if (enabled)
+        record(name, 'i');
+}
+
+void Tracer::setFrame(int64 frame)
+{
+    currentFrame = frame;
+}
+
+bool Tracer::dump(const std::string& file)
+{
+    if (events.empty())
+        return false;
+
+    FILE* f = std::fopen(file.c_str(), "w");
+    if (!f)
+        return false;
+
+    // stop recording while the buffer is read
+    const bool wasEnabled = enabled;
+    enabled = false;
+
+    const size_t total = next;
+    const size_t count = std::min(total, events.size());
+    const double usPerTick = 1e6/cv::getTickFrequency();
+    const int pid = int(getpid());
+
+    std::fprintf(f, "{\"traceEvents\":[\n");
+    bool first = true;
+    for (size_t k = total - count; k < total; k++) {
+        const TraceEvent& e = events[k % events.size()];
+        if (!e.name)
+            continue;
+        std::fprintf(f, "%s{\"name\":\"", first ? "" : ",\n");
+        writeName(f, e.name);
+        std::fprintf(f, "\",\"cat\":\"findObject\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d,%s\"args\":{\"frame\":%lld}}",
+                     e.phase, e.ticks*usPerTick, pid, e.tid, e.phase == 'i' ? "\"s\":\"t\"," : "",
+                     (long long)e.frame);
+        first = false;
+    }
+    std::fprintf(f, "\n]}\n");
+    const bool ok = std::fclose(f) == 0;
+
+    enabled = wasEnabled;
+    return ok;
+}
+
+void Tracer::requestDump()
+{
+    dumpRequested = 1;
+}
+
+bool Tracer::takeDumpRequest()
+{
+    if (!dumpRequested)
+        return false;
+    dumpRequested = 0;
+    return true;
+}
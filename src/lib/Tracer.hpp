@@ -0,0 +1,81 @@
+#ifndef TRACER_HPP
+#define TRACER_HPP
+
+////////////////////////////////////////////////////////////////////
+// File includes:
+#include <opencv2/core/core.hpp>
+
+#include <string>
+
+/**
+ * Begin/end spans and instant events of the pipeline, kept in a preallocated ring buffer
+ * (the oldest events are overwritten) and written as Chrome trace-event JSON, which
+ * chrome://tracing and Perfetto open.
+ * Recording is disabled until init() is called; then it costs one atomic increment and
+ * a timestamp per event. Event names must be string literals (only the pointer is kept).
+ */
+class Tracer
+{
+public:
+    /**
+     * Allocate the buffer for @capacity events and start recording.
+     */
+    static void init(size_t capacity);
+    static bool isEnabled();
+
+    static void begin(const char* name);
+    static void end(const char* name);
+    static void instant(const char* name);
+
+    /**
+     * Frame the following events belong to, stored in their arguments.
+     */
+    static void setFrame(int64 frame);
+
+    /**
+     * Write the buffered events to @file. Returns false if the file cannot be written.
+     */
+    static bool dump(const std::string& file);
+
+    /**
+     * Ask for a dump from a signal handler: only sets a flag, see takeDumpRequest().
+     */
+    static void requestDump();
+    static bool takeDumpRequest();
+};
+
+/**
+ * Span covering the lifetime of the object.
+ */
+class TraceSpan
+{
+public:
+    explicit TraceSpan(const char* name)
+    : m_name(Tracer::isEnabled() ? name : 0)
+    {
+        if (m_name)
+            Tracer::begin(m_name);
+    }
+
+    ~TraceSpan()
+    {
+        if (m_name)
+            Tracer::end(m_name);
+    }
+
+private:
+    const char* m_name;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+#define TRACE_SCOPE(name) TraceSpan TRACE_CONCAT(traceSpan_, __LINE__)(name)
+
+#define TRACE_INSTANT(name) \
+    do { \
+        if (Tracer::isEnabled()) \
+            Tracer::instant(name); \
+    } while (0)
+
+#endif
@@ -0,0 +1,185 @@
+////////////////////////////////////////////////////////////////////
+// File includes:
+#include "ViewpointPlanner.hpp"
+#include "TaskScheduler.hpp"
+
+////////////////////////////////////////////////////////////////////
+// Standard includes:
+#include <cmath>
+#include <algorithm>
+
+namespace
+{
+    double angleDiff(double a, double b)
+    {
+        double d = std::fmod(a - b, 2*CV_PI);
+        if (d > CV_PI)  d -= 2*CV_PI;
+        if (d < -CV_PI) d += 2*CV_PI;
+        return d;
+    }
+
+    class ViewpointScore : public cv::ParallelLoopBody {
+        const ViewpointPlanner& planner;
+        const cv::Mat& map;
+        const std::vector<cv::Point>& positions;
+        cv::Point robot;
+        double robotYaw;
+        const cv::Mat& travelCost;
+        std::vector<Viewpoint>& candidates;
+
+    public:
+        ViewpointScore(const ViewpointPlanner& planner, const cv::Mat& map, const std::vector<cv::Point>& positions,
+                       cv::Point robot, double robotYaw, const cv::Mat& travelCost, std::vector<Viewpoint>& candidates)
+            : planner(planner), map(map), positions(positions), robot(robot), robotYaw(robotYaw),
+              travelCost(travelCost), candidates(candidates) {}
+
+        void operator() (const cv::Range& range) const {
+            for (int i = range.start; i != range.end; i++) {
+                Viewpoint& vp = candidates[i];
+                vp.cell = positions[i / planner.yawSamples];
+                vp.yaw = (i % planner.yawSamples) * 2*CV_PI / planner.yawSamples;
+
+                vp.time = planner.travelTime(travelCost, robot, robotYaw, vp.cell, vp.yaw);
+                if (vp.time < 0) { // unreachable
+                    vp.gain = 0;
+                    vp.time = 0;
+                    vp.score = -1;
+                    continue;
+                }
+
+                vp.gain = planner.newCoverage(map, vp.cell, vp.yaw);
+                vp.score = vp.gain/vp.time;
+            }
+        }
+    };
+}
+
+ViewpointPlanner::ViewpointPlanner()
+: hfov(1.0)
+, range(60)
+, yawSamples(8)
+, linearSpeed(6)
+, angularSpeed(0.5)
+, fixedCost(2)
+{
+}
+
+void ViewpointPlanner::raycast(const cv::Mat& map, cv::Point cell, double yaw, std::vector<cv::Point>& visible) const
+{
+    visible.clear();
+    if (!cv::Rect(0, 0, map.cols, map.rows).contains(cell))
+        return;
+
+    // one ray per cell of the far end of the frustum
+    const int rays = std::max(3, int(std::ceil(hfov*range)) + 1);
+    const int steps = int(range);
+    visible.reserve(rays*steps/2);
+
+    for (int k = 0; k < rays; k++) {
+        const double a = yaw - hfov/2 + k*hfov/(rays - 1);
+        const double dx = std::cos(a), dy = std::sin(a);
+        for (int t = 0; t <= steps; t++) {
+            const int x = int(std::floor(cell.x + 0.5 + t*dx));
+            const int y = int(std::floor(cell.y + 0.5 + t*dy));
+            if (x < 0 || y < 0 || x >= map.cols || y >= map.rows)
+                break;
+            visible.push_back(cv::Point(x,y));
+            if (map.at<uchar>(y,x) == MAP_OCCUPIED)
+                break;
+        }
+    }
+}
+
+void ViewpointPlanner::frustumMask(const cv::Mat& map, cv::Point cell, double yaw, cv::Mat& mask, cv::Rect& roi) const
+{
+    const int r = int(std::ceil(range)) + 1;
+    roi = cv::Rect(cell.x - r, cell.y - r, 2*r + 1, 2*r + 1) & cv::Rect(0, 0, map.cols, map.rows);
+    mask = cv::Mat::zeros(roi.size(), CV_8U);
+
+    std::vector<cv::Point> visible;
+    raycast(map, cell, yaw, visible);
+    for (size_t i = 0; i < visible.size(); i++)
+        mask.at<uchar>(visible[i] - roi.tl()) = 255;
+}
+
+double ViewpointPlanner::travelTime(const cv::Mat& travelCost, cv::Point robot, double robotYaw,
+                                    cv::Point cell, double yaw) const
+{
+    double distance;
+    if (travelCost.empty()) {
+        const cv::Point d = cell - robot;
+        distance = std::sqrt(double(d.dot(d)));
+    } else {
+        distance = travelCost.at<float>(cell);
+    }
+    if (distance < 0)
+        return -1;
+
+    return fixedCost + distance/linearSpeed + std::fabs(angleDiff(yaw, robotYaw))/angularSpeed;
+}
+
+void ViewpointPlanner::ensureSize(const cv::Mat& map)
+{
+    if (m_coverage.size() != map.size())
+        m_coverage = cv::Mat::zeros(map.size(), CV_8U);
+}
+
+void ViewpointPlanner::markObserved(const cv::Mat& map, cv::Point cell, double yaw)
+{
+    ensureSize(map);
+
+    std::vector<cv::Point> visible;
+    raycast(map, cell, yaw, visible);
+    for (size_t i = 0; i < visible.size(); i++)
+        m_coverage.at<uchar>(visible[i]) = 255;
+}
+
+int ViewpointPlanner::newCoverage(const cv::Mat& map, cv::Point cell, double yaw) const
+{
+    std::vector<cv::Point> visible;
+    raycast(map, cell, yaw, visible);
+
+    // unique cells, as linear indices
+    std::vector<int> cells(visible.size());
+    for (size_t i = 0; i < visible.size(); i++)
+        cells[i] = visible[i].y*map.cols + visible[i].x;
+    std::sort(cells.begin(), cells.end());
+    cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+
+    const bool hasCoverage = m_coverage.size() == map.size();
+    int gain = 0;
+    for (size_t i = 0; i < cells.size(); i++)
+        if (!hasCoverage || m_coverage.data[cells[i]] == 0)
+            gain++;
+    return gain;
+}
+
+bool ViewpointPlanner::selectBest(const cv::Mat& map, const std::vector<cv::Point>& positions,
+                                  cv::Point robot, double robotYaw, const cv::Mat& travelCost,
+                                  Viewpoint& best, int minGain) const
+{
+    if (positions.empty() || yawSamples <= 0)
+        return false;
+
+    std::vector<Viewpoint> candidates(positions.size()*yawSamples);
+    TaskScheduler::parallelFor(cv::Range(0, candidates.size()),
+                               ViewpointScore(*this, map, positions, robot, robotYaw, travelCost, candidates));
+
+    int bestIdx = -1;
+    for (size_t i = 0; i < candidates.size(); i++) {
+        if (candidates[i].gain < minGain)
+            continue;
+        if (bestIdx < 0 || candidates[i].score > candidates[bestIdx].score)
+            bestIdx = i;
+    }
+    if (bestIdx < 0)
+        return false;
+
+    best = candidates[bestIdx];
+    return true;
+}
+
+const cv::Mat& ViewpointPlanner::getCoverage() const
+{
+    return m_coverage;
+}
@@ -0,0 +1,88 @@
+#ifndef VIEWPOINTPLANNER_HPP
+#define VIEWPOINTPLANNER_HPP
+
+////////////////////////////////////////////////////////////////////
+// File includes:
+#include "OccupancyMap.hpp"
+
+#include <opencv2/opencv.hpp>
+
+#include <vector>
+
+/**
+ * Robot position (map cell) and heading of the camera.
+ */
+struct Viewpoint
+{
+    cv::Point cell;
+    double    yaw;
+    int       gain;     // cells that would be observed for the first time
+    double    time;     // estimated travel time from the robot, seconds
+    double    score;
+};
+
+/**
+ * Chooses where to look next by raycasting the horizontal camera frustum over the map and
+ * keeping a grid of the cells already observed.
+ * Cells are (x = column, y = row); yaw is measured from the x axis of the map.
+ */
+class ViewpointPlanner
+{
+public:
+    ViewpointPlanner();
+
+    /**
+     * Visible cells from @cell looking at @yaw. Rays stop at occupied cells and at the map border.
+     * The result may contain duplicates near the origin.
+     */
+    void raycast(const cv::Mat& map, cv::Point cell, double yaw, std::vector<cv::Point>& visible) const;
+
+    /**
+     * Visible cells from the pose as a CV_8U mask (255 where visible) of the part @roi of the map.
+     */
+    void frustumMask(const cv::Mat& map, cv::Point cell, double yaw, cv::Mat& mask, cv::Rect& roi) const;
+
+    /**
+     * Estimated time (seconds) to reach @cell with heading @yaw from @robot/@robotYaw,
+     * negative if unreachable. @travelCost as in selectBest().
+     */
+    double travelTime(const cv::Mat& travelCost, cv::Point robot, double robotYaw,
+                      cv::Point cell, double yaw) const;
+
+    /**
+     * Mark as observed the cells visible from the given pose. The coverage grid is reset if the map size changed.
+     */
+    void markObserved(const cv::Mat& map, cv::Point cell, double yaw);
+
+    /**
+     * Number of cells visible from the pose that have not been observed yet.
+     */
+    int newCoverage(const cv::Mat& map, cv::Point cell, double yaw) const;
+
+    /**
+     * Evaluate every position of @positions with @yawSamples headings (in parallel) and return the one
+     * maximizing new coverage per unit of travel time from @robot/@robotYaw.
+     * @travelCost is the path length in cells from the robot (see FrontierPlanner::computeCostMap),
+     * negative where unreachable; if empty the straight line distance is used.
+     * Returns false if no candidate observes at least @minGain new cells.
+     */
+    bool selectBest(const cv::Mat& map, const std::vector<cv::Point>& positions,
+                    cv::Point robot, double robotYaw, const cv::Mat& travelCost,
+                    Viewpoint& best, int minGain = 1) const;
+
+    const cv::Mat& getCoverage() const;
+
+    double hfov;            // horizontal field of view, radians
+    double range;           // max range, cells
+    int    yawSamples;      // headings evaluated per position
+    double linearSpeed;     // cells per second
+    double angularSpeed;    // radians per second
+    double fixedCost;       // seconds added to every goal (planning, acceleration)
+
+private:
+    void ensureSize(const cv::Mat& map);
+
+    cv::Mat m_coverage;     // 255 where observed
+};
+
+#endif
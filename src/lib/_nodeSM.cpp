@@ -1,70 +1,203 @@
 #include "_nodeSM.hpp"
-#include <stdlib.h>     /* srand, rand */
 #include <time.h>       /* time */
+#include <boost/thread/mutex.hpp>
+
+/**
+ * Orientation (in camera link) of an object whose face has the given normal in the camera
+ * optical frame. The x axis points into the face, the z axis stays as close as possible to
+ * the camera link up axis. @yaw gets the heading of the x axis.
+ */
+static geometry_msgs::Quaternion faceOrientation(const cv::Vec3f& normal, double& yaw){
+    // optical (x right, y down, z forward) to camera link (x forward, y left, z up)
+    tf::Vector3 x(-normal[2], normal[0], normal[1]);
+    yaw = std::atan2(x.y(), x.x());
+
+    tf::Vector3 up(0, 0, 1);
+    tf::Vector3 y = up.cross(x);
+    if (y.length() < 1e-3) // face looking up or down: keep the heading only
+        return tf::createQuaternionMsgFromYaw(yaw);
+    x.normalize();
+    y.normalize();
+    tf::Vector3 z = x.cross(y);
+
+    tf::Matrix3x3 basis(x.x(), y.x(), z.x(),
+                        x.y(), y.y(), z.y(),
+                        x.z(), y.z(), z.z());
+    tf::Quaternion q;
+    basis.getRotation(q);
+    geometry_msgs::Quaternion qt;
+    tf::quaternionTFToMsg(q, qt);
+    return qt;
+}
 
-static double GOAL_DISTANCE = 0.5;
-
-static double angle( Point pt1, Point pt2, Point pt0 ){
-    double dx1 = pt1.x - pt0.x;
-    double dy1 = pt1.y - pt0.y;
-    double dx2 = pt2.x - pt0.x;
-    double dy2 = pt2.y - pt0.y;
-    return (dx1*dx2 + dy1*dy2)/sqrt((dx1*dx1 + dy1*dy1)*(dx2*dx2 + dy2*dy2) + 1e-10);
+static const char* stateName(STATE_VAR state){
+    static const char* names[] = {
+        "_DEFAULT", "_OBJECT_NOT_FOUND", "_OBJECT_FOUND", "_WAITING_POSE",
+        "_DIFF_POSE_NOT_REACHED", "_DIFF_POSE_REACHED", "_WAITING_TARGET",
+        "_TARGET_NOT_REACHABLE", "_TARGET_REACHED", "_ROBUST_OBJECT_FOUND",
+        "_ROBUST_OBJECT_NOT_FOUND"
+    };
+    return names[state];
 }
 
-static double distance( Point pt1, Point pt2 ){
-    double dx = pt1.x - pt2.x;
-    double dy = pt1.y - pt2.y;
-    return dx*dx+dy*dy;
+static void traceSignal(int){
+    Tracer::requestDump();
 }
 
-struct espx_sorter {
-    bool operator() (cv::Point2f pt1, cv::Point2f pt2) { return (pt1.x < pt2.x);}
-} esp_sortx;
-struct espy_sorteru {
-    bool operator() (cv::Point2f pt1, cv::Point2f pt2) { return (pt1.y > pt2.y);}
-} esp_sortyu;
-struct espy_sorterd {
-    bool operator() (cv::Point2f pt1, cv::Point2f pt2) { return (pt1.y < pt2.y);}
-} esp_sortyd;
+static boost::mutex processInitMutex;
+static bool processInitDone = false;
+
+void ObjectFinder::initProcess(bool ownProcess){
+    // several finders may share a nodelet manager: the pool and the tracer are set up once
+    boost::mutex::scoped_lock lock(processInitMutex);
+    if (processInitDone)
+        return;
+    processInitDone = true;
+
+    ros::NodeHandle nh;
+    // threads of the parallel stages besides the main one (-1: one per CPU minus one),
+    // each pinned to a CPU with task_affinity
+    int taskWorkers;
+    bool taskAffinity;
+    nh.param<int>("/findObject/task_workers", taskWorkers, -1);
+    nh.param<bool>("/findObject/task_affinity", taskAffinity, false);
+    TaskScheduler::init(taskWorkers, taskAffinity);
+
+    // Chrome trace of the last ~trace_capacity events, written on exit, and on SIGUSR1 when
+    // the process is ours (not a nodelet manager shared with other nodelets)
+    std::string traceFile;
+    int traceCapacity;
+    nh.param<std::string>("/findObject/trace_file", traceFile, "");
+    nh.param<int>("/findObject/trace_capacity", traceCapacity, 1<<16);
+    if (!traceFile.empty()){
+        Tracer::init(traceCapacity);
+        if (ownProcess)
+            signal(SIGUSR1, traceSignal);
+    }
+}
 
-ObjectFinder::ObjectFinder(){
+ObjectFinder::ObjectFinder(const ros::NodeHandle& nh) : nh_(nh), stopRequested(false){
     _CURRENT_STATE = _DEFAULT;
+    nh_.setCallbackQueue(&callbacks);
 
     vel_pub_ = nh_.advertise<geometry_msgs::Twist>("/cmd_vel", 1);
     diff_pub_ = nh_.advertise<geometry_msgs::PoseStamped>("/diff_pose",1);
     pose_pub_ = nh_.advertise<geometry_msgs::PoseStamped>("/object_pose",1);
     gopose_pub_ = nh_.advertise<geometry_msgs::PoseStamped>("/go_pose",1);
-    mapSub = nh_.subscribe("/map",10,&ObjectFinder::mapper,this);
     //occSub = nh_.subscribe("/move_base/local_costmap/inflated_obstacles",10,&ObjectFinder::mapperobs,this);
 
     nh_.param<std::string>("/findObject/template_name", template_name, "/home/roboticslab/groovy_workspace/sandbox/findObject/data/qr.jpg");
     nh_.param<std::string>("/findObject/kinect_frame_name", kinect_frame_name, "/camera_depth_optical_frame");
     nh_.param<std::string>("/findObject/robot_frame_name", fixed_frame, "/map");
+    nh_.param<std::string>("/findObject/base_frame_name", base_frame, "/base_link");
+    // frame of the object poses (x forward, y left, z up), also recorded by findObject_record
+    nh_.param<std::string>("/findObject/camera_frame_name", camera_frame, "/camera_link");
+    nh_.param<double>("/findObject/frontier_cost_weight", frontiers.costWeight, frontiers.costWeight);
+    nh_.param<int>("/findObject/frontier_min_size", frontiers.minClusterSize, frontiers.minClusterSize);
+    nh_.param<bool>("/findObject/viewpoint_planning", useViewpoints, true);
+    nh_.param<double>("/findObject/view_range", viewRange, 3.0);
+    nh_.param<double>("/findObject/robot_speed", robotSpeed, 0.3);
+    nh_.param<int>("/findObject/view_min_gain", minViewGain, 20);
+    nh_.param<bool>("/findObject/belief_search", useBelief, true);
+    nh_.param<double>("/findObject/belief_min_detection", minDetection, 0.01);
+    double detectionProb;
+    nh_.param<double>("/findObject/detection_prob", detectionProb, belief.detectionProb);
+    belief.detectionProb = detectionProb;
+    nh_.param<double>("/findObject/robot_radius", robotRadius, 0.2);
+    // meters between the robot and the object face at the approach goals
+    nh_.param<double>("/findObject/goal_distance", goalDistance, 0.5);
     nh_.param<std::string>("/findObject/depth_node_name", depth_node_name, "/camera/depth/image_raw");
     //nh_.param<std::string>("/findObject/rgb_node_name", rgb_node_name, "/img_comp");
     nh_.param<std::string>("/findObject/rgb_node_name", rgb_node_name, "/camera/rgb/image_raw");
     nh_.param<std::string>("/findObject/caminfo_node_name", caminfo_node_name, "/camera/rgb/camera_info");
-
-    ac = new MoveBaseClient("move_base", true);
+    nh_.param<bool>("/findObject/yaw_robust", perception.params.yawRobust, false);
+    bool planeRansac;
+    nh_.param<bool>("/findObject/plane_ransac", planeRansac, false);
+    perception.params.planeMode = planeRansac ? PLANE_FIT_RANSAC : PLANE_FIT_PCA;
+    nh_.param<bool>("/findObject/undistort_rays", undistortRays, false);
+    // meters per depth unit, 0 to deduce it from the encoding (16UC1 in mm, 32FC1 in m)
+    nh_.param<double>("/findObject/depth_scale", perception.params.depthScale, 0.0);
+    nh_.param<double>("/findObject/min_depth", perception.params.minDepth, 0.3);
+    nh_.param<double>("/findObject/max_depth", perception.params.maxDepth, 10.0);
+    // goal is sent again when the filtered object pose moves more than this (m, rad)
+    nh_.param<double>("/findObject/resend_distance", resendDistance, 0.15);
+    nh_.param<double>("/findObject/resend_yaw", resendYaw, 0.3);
+    // frames between two detections while approaching, once the pose estimate has converged
+    nh_.param<int>("/findObject/track_period", trackPeriod, 5);
+    // seconds between two latency summaries in the log, 0 to disable profiling
+    nh_.param<double>("/findObject/profile_period", profilePeriod, 30.0);
+    // debug images: no window when headless (topics only), drawn at debug_rate Hz (0 for none)
+    // and resized by debug_scale
+    nh_.param<bool>("/findObject/headless", headless, false);
+    nh_.param<double>("/findObject/debug_rate", debugRate, 5.0);
+    nh_.param<double>("/findObject/debug_scale", debugScale, 1.0);
+    Profiler::setEnabled(profilePeriod>0);
+    // trace started by initProcess(), written here by dumpTrace()
+    nh_.param<std::string>("/findObject/trace_file", trace_file, "");
+    // where past sightings are kept across runs, empty to keep them in memory only
+    nh_.param<std::string>("/findObject/memory_file", memory_file, "");
+    nh_.param<double>("/findObject/memory_decay", memory.decayTime, memory.decayTime);
+    // seconds between two writes of memory_file when new sightings came in
+    nh_.param<double>("/findObject/memory_save_period", memorySavePeriod, 10.0);
+    // offline run on a log of findObject_record instead of the topics and move_base;
+    // replay_rate is the speed relative to the recording, 0 for as fast as possible
+    nh_.param<std::string>("/findObject/replay_file", replay_file, "");
+    nh_.param<double>("/findObject/replay_rate", replayRate, 0.0);
+    replaying = !replay_file.empty();
+    replayFrames = 0;
+    replayClock = ros::Time(0);
+    // applyAction returns at once on failure: as a nodelet, the manager has to keep running
+    replayOpen = replaying && replayLog.open(replay_file);
+    if (replaying && !replayOpen)
+        ROS_ERROR("Could not open the replay file %s", replay_file.c_str());
+
+    ac = replaying ? 0 : new MoveBaseClient("move_base", true);
 
     templ = imread(template_name.c_str());
+    if (templ.empty())
+        ROS_ERROR("Could not read template image %s", template_name.c_str());
+    perception.setTemplate(templ);
+
+    if (!memory_file.empty() && memory.load(memory_file))
+        ROS_INFO("Loaded %d past observations from %s", int(memory.size()), memory_file.c_str());
 
     it = new image_transport::ImageTransport(nh_);
-    ima_sub_ = it->subscribe(rgb_node_name, 1,&ObjectFinder::readImage,this);
-    dep_sub_ = it->subscribe(depth_node_name, 1,&ObjectFinder::readDepth,this);
-    cam_info_ =  nh_.subscribe(caminfo_node_name, 1, &ObjectFinder::readKam, this);
+    if (!replaying){
+        mapSub = nh_.subscribe("/map",10,&ObjectFinder::mapper,this);
+        mapUpdSub = nh_.subscribe("/map_updates",10,&ObjectFinder::mapUpdater,this);
+        ima_sub_ = it->subscribe(rgb_node_name, 1,&ObjectFinder::readImage,this);
+        dep_sub_ = it->subscribe(depth_node_name, 1,&ObjectFinder::readDepth,this);
+        cam_info_ =  nh_.subscribe(caminfo_node_name, 1, &ObjectFinder::readKam, this);
+    }
     ima_pub_ = it->advertise("/object_image", 1);
+    map_pub_ = it->advertise("/search_map_image", 1);
+    objectView = viewer.addView("object", ima_pub_);
+    mapView = viewer.addView("map", map_pub_);
+    viewer.start(debugRate, !headless, debugScale);
+    filtered_pub_ = nh_.advertise<geometry_msgs::PoseWithCovarianceStamped>("/object_pose_filtered",1);
     im_ready=false;
     dep_ready=false;
     kam_ready=false;
     mapfready=false;
-
+    plannerStale=false;
+    trackFrames=0;
+    imageFrame=0;
+    lastProfileReport=ros::Time::now();
+    goalObjectYaw=0;
+    memoryDirty=false;
+    lastMemorySave=ros::WallTime::now();
+
+    map_height=0;
+    map_width=0;
+    map_resolution=0;
+    map_origin_x=0;
+    map_origin_y=0;
     init_point = cv::Point(77, 85);
-    srand (time(NULL));
+    // replays must not depend on the wall clock
+    rng = cv::RNG(replaying ? 0 : time(NULL));
 
     // wait for the action server to come up
-    while(!ac->waitForServer(ros::Duration(5.0))) ROS_INFO("Waiting for the move_base action server to come up");
+    while(ac && !ac->waitForServer(ros::Duration(5.0))) ROS_INFO("Waiting for the move_base action server to come up");
     moving=false;
     currPathIdx = 0;
     firsttime = true;
@@ -72,222 +205,68 @@ ObjectFinder::ObjectFinder(){
     findops=0;
 }
 
-static int map_height, map_width, map_origin_x, map_origin_y;
-static double map_resolution;
-
 void ObjectFinder::mapper(const nav_msgs::OccupancyGridPtr& map){
     map_height=map->info.height;
     map_width =map->info.width;
     map_resolution=map->info.resolution;
+    planner.robotRadius = robotRadius/map_resolution;
+    planner.inflationRadius = 2*planner.robotRadius;
+    clearance.maxDistance = planner.inflationRadius + 1; // larger distances are never queried
     map_origin_x=map->info.origin.position.x;
     map_origin_y=map->info.origin.position.y;
 
-    char *vec;
-    vec = new char[map->data.size()];
-    for (size_t i=0; i<map->data.size(); i++){
-        vec[i]=map->data[i];
-    }
-
-    cv::Mat mapa = cv::Mat(map_height, map_width, CV_8S, vec).clone();
-    mapf = cv::Mat::zeros(map_height, map_width, CV_8U);
-
-    //Convert map info in two arrays: explored and occupacy
-    for (int i=0; i<mapa.rows; i++)
-        for (int j=0; j<mapa.cols; j++){
-            if (int(mapa.at<char>(i,j))==-1){
-                mapf.at<uchar>(i,j)=128;
-            }else if(int(mapa.at<char>(i,j))>0){
-                mapf.at<uchar>(i,j)=0;
-            }else{
-                mapf.at<uchar>(i,j)=255;
-            }
-        }
+    //Convert map info in one array: explored and occupacy (128 unknown, 0 occupied, 255 free)
+    convertOccupancyGrid(map->data.empty() ? 0 : &map->data[0], map_width, map_height, mapf);
+    mapDirty = cv::Rect(0, 0, map_width, map_height);
+    clearance.setMap(mapf);
+    plannerStale = true;
 
-    cv::Mat map_proc=mapf.clone();
-    cv::Mat color_map;
-    cv::cvtColor(map_proc, color_map, CV_GRAY2BGR);
     mapfready=true;
-    mapSub.shutdown();
-    cv::circle(color_map, init_point, 2, cv::Scalar(0,255,0), 2);
-    cv::imshow("map", color_map);
-
-    delete [] vec;
-}
-
-double ObjectFinder::findObjectYaw(const cv::Mat &depth, const cv::Mat &mask,
-                                   double alpha_x, double u0, const cv::Rect &rec){
-    double yaw=0.0;
-
-    double px=rec.x;
-    cv::Mat zvals;
-    depth.convertTo(zvals, CV_64FC1);
-
-    int N = int(cv::sum(mask)[0]/255);
-
-    cv::Mat X = cv::Mat::ones(N,2,CV_64FC1);
-    cv::Mat Z = cv::Mat::ones(N,1,CV_64FC1);
-    int cont=0;
-    for (int i=0; i<depth.rows; i++){
-        for (int j=0; j<depth.cols; j++){
-            double zval = zvals.at<double>(i,j);
-            int masked = mask.at<uchar>(i,j);
-
-            if (masked!=0){
-                X.at<double>(cont,0) = (j+px-u0)*zval/alpha_x;
-                Z.at<double>(cont,0) = zval;
-                cont++;
-            }
-        }
+    if (viewer.wants(mapView)){
+        cv::Mat color_map;
+        cv::cvtColor(mapf, color_map, CV_GRAY2BGR);
+        cv::circle(color_map, init_point, 2, cv::Scalar(0,255,0), 2);
+        viewer.post(mapView, color_map, ros::Time::now());
     }
-    X = X - *std::min_element(X.begin<double>(), X.end<double>());
-    cv::Mat B = (X.t()*X).inv()*X.t()*Z;
-
-    cv::Mat Z2 = B.at<double>(0,0)*X.col(0)+B.at<double>(1,0);
-
-    yaw = std::atan2( (Z2.at<double>(N-1,0)-Z2.at<double>(0,0)),(X.at<double>(N-1,0)-X.at<double>(0,0)) );
-
-    return yaw;
 }
 
-geometry_msgs::Quaternion ObjectFinder::getRotMat(CameraCalibration cc, cv::Size sz, std::vector<Point2f> points2d){
-
-    cv::Mat Rvec;
-    cv::Mat_<float> Tvec;
-    cv::Mat raux,taux;
-
-    std::sort(points2d.begin(), points2d.end(), esp_sortx); //organizing by x component
-    std::sort(points2d.begin(), points2d.begin()+1, esp_sortyu); //organizing by y (the first two): the biggest y is the first
-    std::sort(points2d.end()-1, points2d.end(), esp_sortyd); //organizing the last two: the biggest y is last
+void ObjectFinder::mapUpdater(const map_msgs::OccupancyGridUpdateConstPtr& update){
+    // patches are only meaningful on top of a full map
+    if (!mapfready || update->data.size() < size_t(update->width)*update->height)
+        return;
 
-    // Normalized dimensions:
-    const float maxSize = std::max(sz.height, sz.width);
-    const float unitW = sz.width / maxSize;
-    const float unitH = sz.height / maxSize;
-    std::vector<Point3f> points3d(4);
-    points3d[0] = cv::Point3f(-unitW, -unitH, 0);
-    points3d[1] = cv::Point3f(-unitW, unitH, 0);
-    points3d[2] = cv::Point3f(unitW, unitH, 0);
-    points3d[3] = cv::Point3f(unitW, -unitH, 0);
-    cv::solvePnP(points3d, points2d, cc.getIntrinsic(), cc.getDistorsion(),raux,taux);
-    raux.convertTo(Rvec,CV_32F);
-    taux.convertTo(Tvec ,CV_32F);
-
-    cv::Mat_<float> rotMat(3,3);
-    cv::Rodrigues(Rvec, rotMat);
-    tf::Quaternion q;
-    //q.setRotation(tf::Vector3(0,0,1), acos((rotMat(0,0)+rotMat(1,1))/2));
-    q.setRotation(tf::Vector3(0,0,1), acos(rotMat(0,0)));
-    geometry_msgs::Quaternion qt;
-    quaternionTFToMsg(q,qt);
-    return qt;
+    cv::Rect window(update->x, update->y, update->width, update->height);
+    cv::Rect changed = applyOccupancyPatch(update->data.empty() ? 0 : &update->data[0], window, mapf);
+    mapDirty = mapDirty.area()>0 ? (mapDirty | changed) : changed;
+    clearance.update(mapf, changed);
+    plannerStale = plannerStale || changed.area()>0;
 }
 
 Rect ObjectFinder::getBB(std::vector<cv::Point>  obj){
-    Point ini, end;
-    ini.x=ini.y=10000;
-    end.x=end.y=0;
-    for ( size_t j = 0; j < obj.size(); j++ ){
-        ini.x = std::min(ini.x, obj[j].x);
-        ini.y = std::min(ini.y, obj[j].y);
-        end.x = std::max(end.x, obj[j].x);
-        end.y = std::max(end.y, obj[j].y);
-    }
-    return Rect(ini, end);
-}
-
-std::vector<cv::Point> ObjectFinder::getMostSimilObj(std::vector<std::vector<Point> > squares, const cv::Mat I){
-    std::vector<cv::Point>  out;
-    if (squares.size()>0){
-        float maxd=0.0;
-        int maxii=0.0;
-        for( size_t i = 0; i < squares.size(); i++ ){
-            float dis=0.0;
-            std::vector<cv::Point> objectCoor = squares[i];
-            Rect r=getBB(objectCoor);
-            cv::Mat roi( I.clone(), r );
-            cvtColor( roi, roi, CV_BGR2HSV );
-            cvtColor( templ, templ, CV_BGR2HSV );
-
-            int h_bins = 30; int s_bins = 30;
-            int histSize[] = { h_bins, s_bins };
-            float h_ranges[] = { 0, 256 }, s_ranges[] = { 0, 180 };
-            const float* ranges[] = { h_ranges, s_ranges };
-            int channels[] = { 0, 1 };
-
-            MatND hist_base, hist_test;
-            calcHist( &templ, 1, channels, Mat(), hist_base, 2, histSize, ranges, true, false );
-            normalize( hist_base, hist_base, 0, 1, NORM_MINMAX, -1, Mat() );
-            calcHist( &roi, 1, channels, Mat(), hist_test, 2, histSize, ranges, true, false );
-            normalize( hist_test, hist_test, 0, 1, NORM_MINMAX, -1, Mat() );
-
-            dis = compareHist( hist_base, hist_test, CV_COMP_CHISQR );
-            if (dis>0.375) squares[i].clear(); //if too disimilar, eliminate
-
-            if (dis>maxd){
-                maxd=dis;
-                maxii=i;
-            }
-        }
-        out=squares[maxii];
-    }
-    return out;
+    return squareBoundingBox(obj);
 }
 
 void ObjectFinder::detectObject(const cv::Mat& I, std::vector<cv::Point>& objectCoor){
-
-     Mat occludedSquare = I.clone();
-
-     Mat occludedSquare8u;
-     cvtColor(occludedSquare, occludedSquare8u, CV_BGR2GRAY);
-
-     Mat thresh;
-     adaptiveThreshold(occludedSquare8u, thresh, 255, ADAPTIVE_THRESH_MEAN_C ,
-                       THRESH_BINARY_INV, 3, 10);
-
-     std::vector<std::vector<Point> > contours;
-     findContours(thresh, contours, RETR_LIST, CHAIN_APPROX_SIMPLE);
-     std::vector<Point> approx;
-
-     std::vector<std::vector<Point> > squares;
-
-     for( size_t i = 0; i < contours.size(); i++ ){
-         approxPolyDP(Mat(contours[i]), approx, arcLength(Mat(contours[i]), true)*0.02, true);
-         if( approx.size() == 4 &&
-             fabs(contourArea(Mat(approx))) > 150 &&
-             fabs(contourArea(Mat(approx))) < 22000 &&
-             isContourConvex(Mat(approx)) ){
-             double maxCosine = 0;
-
-             for( int j = 2; j < 5; j++ ){
-                 double cosine = fabs(angle(approx[j%4], approx[j-2], approx[j-1]));
-                 maxCosine = MAX(maxCosine, cosine);
-             }
-             double edgeratio = (distance(approx[0],approx[1])+distance(approx[2],approx[3]))
-                                /(distance(approx[1],approx[2])+distance(approx[3],approx[0]));
-
-             if( maxCosine < 0.25 && edgeratio>0.35 && edgeratio<1.65)
-                 squares.push_back(approx);
-         }
-     }
-
-     objectCoor = getMostSimilObj(squares, I);
+    perception.detect(I, objectCoor);
 }
 
 void ObjectFinder::applyAction(  ){
     cv::Mat image_use; // rgb image buffer
     cv::Mat image; // rgb image buffer
-    cv::Mat depth; // depth image buffer
     std::vector<cv::Point> lastCoor; // detected object: coordinates in image frame (2d)
     float Zobj=0.0; // object depth value
     cv::Point p;
     cv::Mat groi, gmask;
+    cv::Rect gbox; // where groi was taken in the depth image
 
-    cv_bridge::CvImagePtr frame = boost::make_shared< cv_bridge::CvImage >(); // bridged image pointer for publishing
-    frame->encoding = sensor_msgs::image_encodings::BGR8;
+    if (replaying && !replayOpen){
+        viewer.stop();
+        return;
+    }
 
     std::cout<<"STARTING STATE MACHINE!..."<<std::endl;
 
-    while (ros::ok()){
+    while (ros::ok() && !stopRequested){
 
         if (im_ready){
             image=rgb_im.clone(); //drawing
@@ -295,6 +274,7 @@ void ObjectFinder::applyAction(  ){
 
             im_ready=false;
 
+            TRACE_SCOPE(stateName(_CURRENT_STATE));
             switch (_CURRENT_STATE){
 
             case _DEFAULT:
@@ -305,21 +285,37 @@ void ObjectFinder::applyAction(  ){
                 // EXPLORE: DIFFERENTIAL MOTION
             {
                 std::cout<<"DIFF MOTION"<<std::endl;
-                if (yawAnglePose==0 || firsttime){
-                    if (currPathIdx>=pathGraph.size() || firsttime){
-                        pather();
-                        currPathIdx = 0;
-                    }
+                // target lost or not reachable: the old track must not gate the next sighting
+                poseFilter.reset();
+                double goalYaw;
+                if (!nextViewpoint(p, goalYaw)){
+                    // fixed rotation steps at each point of the path
+                    if (yawAnglePose==0 || firsttime){
+                        if (currPathIdx>=pathGraph.size() || firsttime){
+                            pather();
+                            currPathIdx = 0;
+                        }
 
-                    p = pathGraph[currPathIdx];
-                    currPathIdx++;
-                }else{
-                    if (currPathIdx>=pathGraph.size()){
-                        yawAnglePose=0;
-                        break;
-                    }else{
                         p = pathGraph[currPathIdx];
+                        currPathIdx++;
+                    }else{
+                        if (currPathIdx>=pathGraph.size()){
+                            yawAnglePose=0;
+                            break;
+                        }else{
+                            p = pathGraph[currPathIdx];
+                        }
                     }
+                    goalYaw=yawAnglePose;
+                    yawAnglePose=yawAnglePose+2*M_PI/10;
+                    if (yawAnglePose>=2*M_PI) yawAnglePose=0;
+                }
+
+                // do not bother move_base with goals it cannot reach
+                if (!goalReachable(p)){
+                    ROS_INFO("Skipping unreachable goal (%d, %d)", p.x, p.y);
+                    _CURRENT_STATE = _DIFF_POSE_NOT_REACHED;
+                    break;
                 }
 
                 geometry_msgs::Pose_< std::allocator<void> > pos;
@@ -330,9 +326,7 @@ void ObjectFinder::applyAction(  ){
                 pose.header.stamp = ros::Time::now();
                 pose.pose = pos;
                 geometry_msgs::Quaternion qt;
-                tf::quaternionTFToMsg(tf::createQuaternionFromYaw(yawAnglePose),qt);
-                yawAnglePose=yawAnglePose+2*M_PI/10;
-                if (yawAnglePose>=2*M_PI) yawAnglePose=0;
+                tf::quaternionTFToMsg(tf::createQuaternionFromYaw(goalYaw),qt);
                 pose.pose.orientation = qt;
                 diff_pub_.publish(pose);
 
@@ -342,7 +336,7 @@ void ObjectFinder::applyAction(  ){
                 goal.target_pose = pose;
 
                 targetReached=false;
-                ac->sendGoal(goal, boost::bind(&ObjectFinder::goalDone, this, _1));
+                dispatchGoal(goal);
                 moving=true;
 
                 _CURRENT_STATE = _WAITING_POSE;
@@ -365,20 +359,11 @@ void ObjectFinder::applyAction(  ){
             {
                 std::cout<<"SEARCH OBJECT"<<std::endl;
                 std::vector<cv::Point> objectCoor;
-                detectObject(image, objectCoor);
-                if (dep_ready && objectCoor.size()>0){
-                    cv::normalize(dep_im, depth, 0, 255, NORM_MINMAX);
-                    depth.convertTo(depth, CV_8UC1);
-
-                    // objected detected: compute object depth
-                    Rect r=getBB(objectCoor);
-                    cv::Mat roi( dep_im, r );
-                    groi=roi.clone();
-                    cv::Mat mask( depth, r );
-                    cv::threshold(mask, mask, 5, 255, THRESH_BINARY); // omit bas depth readings
-                    gmask=mask.clone();
-                    Zobj = mean(roi, mask)[0]/1000; //apparently there is aproblem  with gazebo (units mm or m?)
-                    //Zobj = mean(roi, mask)[0]; //apparently there is aproblem  with gazebo (units mm or m?)
+                DepthStats dstats;
+                bool seen = measureObject(image, objectCoor, groi, gmask, gbox, dstats);
+                observeFromRobot(seen);
+                if (seen){
+                    Zobj = dstats.median;
 
                     const Point* po = &objectCoor[0];
                     int n = 4;
@@ -387,6 +372,7 @@ void ObjectFinder::applyAction(  ){
                     lastCoor = objectCoor;
 
                     init_point = p; // update init_point with the point that last saw the object
+                    poseFilter.reset(); // found by the search: a new track starts at this sighting
                     _CURRENT_STATE = _OBJECT_FOUND;
                     if (moving){
                         moving=false; //Its actually moving, but i want to send the next goal safely
@@ -413,62 +399,49 @@ void ObjectFinder::applyAction(  ){
                     kam_ready=false;
 
                     cv::Rect r=getBB(lastCoor);
-                    float u = r.x + r.width/2, v = r.y + r.height/2;
-
-                    float alpha_x=kam.at(0), alpha_y = kam.at(4);
-                    float uo = kam.at(2), vo = kam.at(5);
-                    // compute full 3D coordinates of the object (based on calibration)
-                    float Xobj = (u-uo)*Zobj/alpha_x;
-                    float Yobj = (v-vo)*Zobj/alpha_y;
-                    // now estimate rotation Quaternion
-                    cv::circle(image, cv::Point(u,v), 5, Scalar(0,255,255),2);
-
-                    double yaw = findObjectYaw(groi, gmask, alpha_x, uo, r);
-                    //std::cout<<"YAW: "<<yaw*180/M_PI<<std::endl;
-
-                    // find object pose in camera link
-                    tf::Vector3 point(Xobj,Yobj,Zobj);
-                    geometry_msgs::Pose_< std::allocator<void> > pos;
-                    pos.position.x = point.z();
-                    pos.position.y = -point.x();
-                    pos.position.z = -point.y();
-                    pos.orientation = tf::createQuaternionMsgFromRollPitchYaw(0,0,yaw);
-
-                    geometry_msgs::PoseStamped pose;
-                    pose.header.frame_id="/camera_link";
-                    pose.header.stamp = ros::Time::now();
-                    pose.pose = pos;
-                    pose_pub_.publish(pose);
-
-                    // find pose to reach in camera link
-                    geometry_msgs::PoseStamped gopose;
-                    gopose=pose;
-                    gopose.pose.position.x = pose.pose.position.x - GOAL_DISTANCE*cos(yaw);
-                    gopose.pose.position.y = pose.pose.position.y - GOAL_DISTANCE*sin(yaw);
-                    gopose_pub_.publish(gopose);
+                    cv::circle(image, cv::Point(r.x + r.width/2, r.y + r.height/2), 5, Scalar(0,255,255),2);
 
-                    // send goal to ac (he will solve the frame)
-                    move_base_msgs::MoveBaseGoal goal;
-                    goal.target_pose.header.frame_id = gopose.header.frame_id;
-                    goal.target_pose.header.stamp = ros::Time::now();
-                    goal.target_pose.pose = gopose.pose;
+                    bool planeFit;
+                    geometry_msgs::PoseStamped pose = objectPose(gbox, groi, gmask, Zobj, planeFit);
+                    pose_pub_.publish(pose);
 
-                    targetReached=false;
-                    ac->sendGoal(goal, boost::bind(&ObjectFinder::goalDone, this, _1));
-                    moving=true;
+                    // find pose to reach: on the map when possible, else in camera link
+                    geometry_msgs::PoseStamped objectMap;
+                    if (mapfready && toFixedFrame(pose, objectMap)){
+                        rememberObject(objectMap, planeFit ? 1.0f : 0.5f);
+                        filterObject(objectMap);
+                        if (!sendApproachGoal()){
+                            ROS_INFO("No reachable pose in front of the object");
+                            _CURRENT_STATE = _TARGET_NOT_REACHABLE;
+                            break;
+                        }
+                    }else{
+                        const double yaw = tf::getYaw(pose.pose.orientation);
+                        geometry_msgs::PoseStamped gopose;
+                        gopose=pose;
+                        gopose.pose.position.x = pose.pose.position.x - goalDistance*cos(yaw);
+                        gopose.pose.position.y = pose.pose.position.y - goalDistance*sin(yaw);
+                        gopose.pose.orientation = tf::createQuaternionMsgFromYaw(yaw);
+                        sendGoal(gopose); // move_base solves the frame
+                    }
 
+                    trackFrames = 0;
                     _CURRENT_STATE = _WAITING_TARGET;
                     //_CURRENT_STATE = _DEFAULT;
                 }
                 break;
 
             case _WAITING_TARGET:
-                // WAIT FOR ACTION TO COMPLETE
+                // WAIT FOR ACTION TO COMPLETE, keep tracking the object on the way
                 if (!moving){
                     if (targetReached)
                         _CURRENT_STATE = _TARGET_REACHED;
                     else
                         _CURRENT_STATE = _TARGET_NOT_REACHABLE;
+                }else if (poseFilter.isInitialized() && mapfready && kam_ready){
+                    // once the estimate has converged, look less often
+                    if (trackFrames++ % (poseFilter.hasConverged() ? trackPeriod : 1) == 0)
+                        trackObject(image);
                 }
                 break;
 
@@ -504,25 +477,48 @@ void ObjectFinder::applyAction(  ){
 
             }
 
-            // publish image
-            image.copyTo(frame->image);
-            frame->header.stamp = ros::Time::now();
-            ima_pub_.publish(frame->toImageMsg());
+            // show and publish the drawing (image is cloned again before the next one)
+            if (viewer.wants(objectView))
+                viewer.post(objectView, image, ros::Time::now());
 
 
             firsttime = false;
         }
 
-        // spin, just once
-        ros::spinOnce();
+        // periodic latency summary
+        if (profilePeriod>0 && (ros::Time::now()-lastProfileReport).toSec()>=profilePeriod){
+            lastProfileReport = ros::Time::now();
+            ROS_INFO("Stage latencies:\n%s", Profiler::report().c_str());
+        }
+
+        if (Tracer::takeDumpRequest())
+            dumpTrace();
+        saveMemory(false);
 
-        // wait
-        cv::waitKey(2);
+        // spin, just once (the queue of nh_, also when running as a nodelet)
+        callbacks.callAvailable();
+        if (replaying && !replayStep())
+            break;
+
+        // wait (not when replaying as fast as possible), the GUI runs in the viewer thread
+        if (!replaying || replayRate>0)
+            ros::WallDuration(0.002).sleep();
+    }
+    viewer.stop();
+    dumpTrace();
+    saveMemory(true);
+
+    if (replaying && replayFrames>0){
+        const double elapsed = (ros::WallTime::now()-replayStart).toSec();
+        ROS_INFO("Replayed %d frames in %.3f s (%.3f ms per frame), %d goals sent",
+                 replayFrames, elapsed, 1e3*elapsed/replayFrames, moveBase.goalsSent());
+        ROS_INFO("Stage latencies:\n%s", Profiler::report().c_str());
     }
 
 }
 
 void ObjectFinder::goalDone(const actionlib::SimpleClientGoalState &state){
+    TRACE_INSTANT("goal.done");
     if(state.state_ == actionlib::SimpleClientGoalState::SUCCEEDED)
         targetReached=true;
     else
@@ -531,54 +527,465 @@ void ObjectFinder::goalDone(const actionlib::SimpleClientGoalState &state){
 }
 
 void ObjectFinder::readImage(const sensor_msgs::ImageConstPtr& kinectImage){
-    cv::Mat im = cv_bridge::toCvShare(kinectImage, "bgr8")->image;
-    if (!im.empty()){
-        im.copyTo(rgb_im);
+    Tracer::setFrame(++imageFrame);
+    TRACE_SCOPE("readImage");
+    // no copy when the message is already bgr8: the state machine clones it before drawing
+    cv_bridge::CvImageConstPtr frame = cv_bridge::toCvShare(kinectImage, "bgr8");
+    if (!frame->image.empty()){
+        rgbFrame = frame;
+        rgb_im = frame->image;
         im_ready=true;
     }
 }
 void ObjectFinder::readDepth(const sensor_msgs::ImageConstPtr& kinectImage){
-    cv::Mat im = cv_bridge::toCvShare(kinectImage)->image;
-    if (!im.empty()){
-        im.copyTo(dep_im);
+    TRACE_SCOPE("readDepth");
+    // shared too, measureObject copies the object region only
+    cv_bridge::CvImageConstPtr frame = cv_bridge::toCvShare(kinectImage);
+    if (!frame->image.empty()){
+        depFrame = frame;
+        dep_im = frame->image;
         dep_ready=true;
     }
 }
 
+void ObjectFinder::requestStop(){
+    stopRequested = true;
+}
+
 void ObjectFinder::readKam(const sensor_msgs::CameraInfoConstPtr &camInfo){
-    kam = camInfo->K;
+    cv::Size size(camInfo->width, camInfo->height);
+
+    // rebuild the calibration and its ray table only when the camera info changes
+    if (!camCalib.hasRayTable() || camInfo->K != kam || camInfo->D != camD || size != camSize){
+        kam = camInfo->K;
+        camD = camInfo->D;
+        camSize = size;
+
+        float dist[5] = {0, 0, 0, 0, 0};
+        for (size_t i=0; i<camD.size() && i<5; i++)
+            dist[i] = camD[i];
+        camCalib = CameraCalibration(kam.at(0), kam.at(4), kam.at(2), kam.at(5), dist);
+        camCalib.buildRayTable(camSize, undistortRays);
+        perception.setCalibration(camCalib);
+    }
     kam_ready = true;
 }
 
+void ObjectFinder::updatePlanner(){
+    if (plannerStale && mapfready){
+        planner.setMap(mapf, clearance);
+        plannerStale = false;
+    }
+}
+
+bool ObjectFinder::goalReachable(const cv::Point& cell){
+    updatePlanner();
+    cv::Point robot, start, goal;
+    double yaw;
+    if (!planner.hasMap() || !robotPose(robot, yaw))
+        return true; // cannot tell
+
+    if (!planner.nearestTraversable(robot, planner.snapRadius, start))
+        return true; // robot not localized in free space
+    return planner.nearestTraversable(cell, planner.snapRadius, goal) && planner.sameComponent(start, goal);
+}
+
+bool ObjectFinder::measureObject(const cv::Mat& image, std::vector<cv::Point>& coor,
+                                 cv::Mat& depth, cv::Mat& mask, cv::Rect& box, DepthStats& stats){
+    stats.count = 0;
+    detectObject(image, coor);
+    if (!dep_ready || coor.empty())
+        return false;
+
+    // objected detected: compute object depth, on the ROI only
+    return perception.measure(dep_im, coor, depth, mask, box, stats);
+}
+
+geometry_msgs::PoseStamped ObjectFinder::objectPose(const cv::Rect& box, const cv::Mat& depth,
+                                                    const cv::Mat& mask, float Zobj, bool& planeFit){
+    PerceptionResult object;
+    perception.estimatePose(box, depth, mask, Zobj, object);
+    planeFit = object.planeFit;
+
+    double yaw;
+    geometry_msgs::Quaternion orientation;
+    if (planeFit)
+        orientation = faceOrientation(object.normal, yaw);
+    else
+        orientation = tf::createQuaternionMsgFromRollPitchYaw(0,0,object.yaw);
+    const float Xobj = object.position.x, Yobj = object.position.y;
+    Zobj = object.position.z;
+
+    // object pose in camera link
+    geometry_msgs::PoseStamped pose;
+    pose.header.frame_id=camera_frame;
+    pose.header.stamp = ros::Time::now();
+    pose.pose.position.x = Zobj;
+    pose.pose.position.y = -Xobj;
+    pose.pose.position.z = -Yobj;
+    pose.pose.orientation = orientation;
+    return pose;
+}
+
+bool ObjectFinder::filterObject(const geometry_msgs::PoseStamped& object){
+    const geometry_msgs::Point& p = object.pose.position;
+    bool accepted = poseFilter.update(object.header.stamp.toSec(), cv::Point3f(p.x, p.y, p.z),
+                                      tf::getYaw(object.pose.orientation));
+    if (!accepted)
+        ROS_INFO("Object pose rejected as outlier");
+
+    geometry_msgs::PoseWithCovarianceStamped filtered;
+    filtered.header = object.header;
+    const cv::Point3f position = poseFilter.getPosition();
+    filtered.pose.pose.position.x = position.x;
+    filtered.pose.pose.position.y = position.y;
+    filtered.pose.pose.position.z = position.z;
+    filtered.pose.pose.orientation = tf::createQuaternionMsgFromYaw(poseFilter.getYaw());
+    const cv::Matx66d cov = poseFilter.getPoseCovariance();
+    for (int i=0; i<36; i++)
+        filtered.pose.covariance[i] = cov.val[i];
+    filtered_pub_.publish(filtered);
+    return accepted;
+}
+
+void ObjectFinder::sendGoal(const geometry_msgs::PoseStamped& gopose){
+    gopose_pub_.publish(gopose);
+
+    move_base_msgs::MoveBaseGoal goal;
+    goal.target_pose.header.frame_id = gopose.header.frame_id;
+    goal.target_pose.header.stamp = ros::Time::now();
+    goal.target_pose.pose = gopose.pose;
+
+    targetReached=false;
+    dispatchGoal(goal);
+    moving=true;
+}
+
+void ObjectFinder::dispatchGoal(const move_base_msgs::MoveBaseGoal& goal){
+    TRACE_INSTANT("goal.send");
+    if (replaying)
+        moveBase.sendGoal(goal, boost::bind(&ObjectFinder::goalDone, this, _1));
+    else
+        ac->sendGoal(goal, boost::bind(&ObjectFinder::goalDone, this, _1));
+}
+
+bool ObjectFinder::replayStep(){
+    LogRecord record;
+    while (replayLog.next(record)){
+        if (replayClock.isZero()){
+            replayStart = ros::WallTime::now();
+            replayFirstStamp = record.stamp;
+            lastProfileReport = ros::Time(record.stamp);
+        }
+        // at the recorded pace: wait for the wall clock to catch up
+        if (replayRate>0){
+            const ros::WallTime due = replayStart + ros::WallDuration((record.stamp-replayFirstStamp)/replayRate);
+            const ros::WallTime now = ros::WallTime::now();
+            if (due > now)
+                (due-now).sleep();
+        }
+        // simulated time, never going back (the topics are not stamped by the same clock)
+        replayClock = std::max(replayClock, ros::Time(record.stamp));
+        ros::Time::setNow(replayClock);
+
+        switch (record.type){
+        case LOG_RGB:
+            readImage(recordToImage(record));
+            replayFrames++;
+            return true; // one frame per iteration of the state machine
+        case LOG_DEPTH:
+            readDepth(recordToImage(record));
+            break;
+        case LOG_CAMERA_INFO:
+            readKam(recordToCameraInfo(record));
+            break;
+        case LOG_MAP:
+            mapper(recordToMap(record));
+            break;
+        case LOG_MAP_UPDATE:
+            mapUpdater(recordToMapUpdate(record));
+            break;
+        case LOG_TRANSFORM:
+            listener.setTransform(recordToTransform(record), "replay");
+            break;
+        case LOG_GOAL_SENT:
+        case LOG_GOAL_RESULT:
+            moveBase.replay(record);
+            break;
+        }
+    }
+    return false;
+}
+
+void ObjectFinder::dumpTrace(){
+    if (trace_file.empty() || !Tracer::isEnabled())
+        return;
+    if (Tracer::dump(trace_file))
+        ROS_INFO("Trace written to %s", trace_file.c_str());
+    else
+        ROS_WARN("Could not write the trace to %s", trace_file.c_str());
+}
+
+bool ObjectFinder::sendApproachGoal(){
+    geometry_msgs::PoseStamped object, gopose;
+    object.header.frame_id = fixed_frame;
+    object.header.stamp = ros::Time::now();
+    const cv::Point3f position = poseFilter.getPosition();
+    object.pose.position.x = position.x;
+    object.pose.position.y = position.y;
+    object.pose.position.z = position.z;
+    object.pose.orientation = tf::createQuaternionMsgFromYaw(poseFilter.getYaw());
+
+    if (!approachPose(object, gopose))
+        return false;
+    sendGoal(gopose);
+    goalObject = position;
+    goalObjectYaw = poseFilter.getYaw();
+    return true;
+}
+
+void ObjectFinder::trackObject(cv::Mat& image){
+    std::vector<cv::Point> coor;
+    cv::Mat depth, mask;
+    cv::Rect box;
+    DepthStats stats;
+    if (!measureObject(image, coor, depth, mask, box, stats))
+        return;
+    kam_ready=false;
+
+    const Point* po = &coor[0];
+    int n = 4;
+    polylines(image, &po, &n, 1, true, Scalar(0,255,255), 2);
+
+    bool planeFit;
+    geometry_msgs::PoseStamped pose = objectPose(box, depth, mask, stats.median, planeFit), objectMap;
+    pose_pub_.publish(pose);
+    if (!toFixedFrame(pose, objectMap) || !filterObject(objectMap))
+        return;
+
+    // move the goal only when the estimate really moved, move_base replans on every new goal
+    const cv::Point3f d = poseFilter.getPosition() - goalObject;
+    const double dyaw = poseFilter.getYaw() - goalObjectYaw;
+    const double yawChange = std::fabs(std::atan2(std::sin(dyaw), std::cos(dyaw)));
+    if (std::sqrt(d.x*d.x + d.y*d.y) > resendDistance || yawChange > resendYaw){
+        ROS_INFO("Object moved, updating the goal");
+        sendApproachGoal();
+    }
+}
+
+bool ObjectFinder::toFixedFrame(const geometry_msgs::PoseStamped& in, geometry_msgs::PoseStamped& out){
+    geometry_msgs::PoseStamped latest = in;
+    latest.header.stamp = ros::Time(0);
+    try{
+        listener.transformPose(fixed_frame, latest, out);
+        out.header.stamp = in.header.stamp;
+        return true;
+    }catch (tf::TransformException &ex){
+        ROS_WARN("%s", ex.what());
+        return false;
+    }
+}
+
+bool ObjectFinder::approachPose(const geometry_msgs::PoseStamped& object, geometry_msgs::PoseStamped& goal){
+    if (clearance.empty() || map_resolution<=0)
+        return false;
+
+    // the x axis of the object points into its face: prefer the side of the ring in front of it
+    const cv::Point2f cell((object.pose.position.x-map_origin_x)/map_resolution,
+                           (object.pose.position.y-map_origin_y)/map_resolution);
+    const double side = tf::getYaw(object.pose.orientation) + M_PI;
+
+    std::vector<ApproachPose> poses;
+    clearance.findApproachPoses(mapf, cell, side, goalDistance/map_resolution,
+                                robotRadius/map_resolution, poses);
+    for (size_t i=0; i<poses.size(); i++){
+        if (!goalReachable(poses[i].cell))
+            continue;
+
+        goal.header.frame_id = fixed_frame;
+        goal.header.stamp = ros::Time::now();
+        goal.pose.position.x = poses[i].cell.x*map_resolution+map_origin_x;
+        goal.pose.position.y = poses[i].cell.y*map_resolution+map_origin_y;
+        goal.pose.position.z = 0;
+        goal.pose.orientation = tf::createQuaternionMsgFromYaw(poses[i].yaw);
+        return true;
+    }
+    return false;
+}
+
+void ObjectFinder::rememberObject(const geometry_msgs::PoseStamped& object, float confidence){
+    Observation o;
+    o.position = cv::Point2f(object.pose.position.x, object.pose.position.y);
+    o.yaw = tf::getYaw(object.pose.orientation);
+    o.stamp = ros::Time::now().toSec();
+    o.confidence = confidence;
+    o.count = 1;
+
+    // the object position is known even when the robot is not localized
+    belief.detect(cv::Point2f((o.position.x-map_origin_x)/map_resolution, (o.position.y-map_origin_y)/map_resolution),
+                  0.3/map_resolution);
+
+    // seen from the robot; if it is not localized, from in front of the face (the object x
+    // axis points into it)
+    cv::Point robot;
+    double robotYaw;
+    if (robotPose(robot, robotYaw)){
+        o.viewpoint = cv::Point2f(robot.x*map_resolution+map_origin_x, robot.y*map_resolution+map_origin_y);
+        o.viewYaw = robotYaw;
+    }else{
+        o.viewpoint = o.position - goalDistance*cv::Point2f(std::cos(o.yaw), std::sin(o.yaw));
+        o.viewYaw = o.yaw;
+    }
+
+    memory.add(o);
+    memoryDirty = true;
+}
+
+void ObjectFinder::saveMemory(bool force){
+    // the whole store is rewritten: at most every memory_save_period, and at exit
+    if (memory_file.empty() || !memoryDirty)
+        return;
+    if (!force && (ros::WallTime::now()-lastMemorySave).toSec()<memorySavePeriod)
+        return;
+    lastMemorySave = ros::WallTime::now();
+    memoryDirty = false;
+    if (!memory.save(memory_file))
+        ROS_WARN("Could not write %s", memory_file.c_str());
+}
+
+bool ObjectFinder::robotPose(cv::Point& cell, double& yaw){
+    if (map_resolution<=0)
+        return false;
+    try{
+        tf::StampedTransform robotTf;
+        listener.lookupTransform(fixed_frame, base_frame, ros::Time(0), robotTf);
+        cell.x = (robotTf.getOrigin().x()-map_origin_x)/map_resolution;
+        cell.y = (robotTf.getOrigin().y()-map_origin_y)/map_resolution;
+        yaw = tf::getYaw(robotTf.getRotation());
+        return true;
+    }catch (tf::TransformException &ex){
+        ROS_WARN("%s", ex.what());
+        return false;
+    }
+}
+
 void ObjectFinder::pather()
 {
-    cv::Mat map_proc=mapf.clone();
-    cv::Mat color_map;
-    cv::cvtColor(map_proc, color_map, CV_GRAY2BGR);
-
-    // Generate N random points within the map
-    int cont_valid_numbers=0;
-    const int N=4;
+    const size_t N=4;
     pathGraph.clear();
     pathGraph.push_back(init_point);
+    if (!mapfready)
+        return;
+
+    // the places the object was most likely seen from
+    std::vector<Observation> seen;
+    memory.mostLikely(ros::Time::now().toSec(), 2, seen);
+    std::vector<cv::Point> viewpoints;
+    for (size_t i=0; i<seen.size(); i++)
+        viewpoints.push_back(cv::Point((seen[i].viewpoint.x-map_origin_x)/map_resolution,
+                                       (seen[i].viewpoint.y-map_origin_y)/map_resolution));
+
+    frontiers.update(mapf, mapDirty);
+    mapDirty = cv::Rect();
+
+    cv::Point start;
+    double yaw;
+    if (!robotPose(start, yaw))
+        start = init_point;
+
+    updatePlanner();
+    ExplorationGoals goals;
+    selectExplorationGoals(mapf, frontiers, planner, start, init_point, viewpoints, N, rng, goals);
+    pathGraph = goals.path;
+
+    if (viewer.wants(mapView)){
+        cv::Mat color_map;
+        cv::cvtColor(mapf, color_map, CV_GRAY2BGR);
+        for (size_t i=0; i<goals.revisits.size(); i++)
+            cv::circle(color_map, goals.revisits[i], 1, cv::Scalar(0,0,255), 2);
+        for (size_t i=0; i<goals.frontiers.size(); i++)
+            cv::circle(color_map, goals.frontiers[i], 1, cv::Scalar(255,0,0), 2);
+        for (size_t i=0; i<goals.samples.size(); i++)
+            cv::circle(color_map, goals.samples[i], 1, cv::Scalar(0,255,0), 2);
+        viewer.post(mapView, color_map, ros::Time::now());
+    }
+}
 
-    while(cont_valid_numbers<N){
-
-        double dx = init_point.x - 10.0 + ( (double)rand() / RAND_MAX )*20;
-        double dy = init_point.y -10.0 + ( (double)rand() / RAND_MAX )*20;
-        //double dx = init_point.x;
-        //double dy = init_point.y;
-
-        int px = dx;
-        int py = dy;
-        cv::Point p = cv::Point(py,px);
+void ObjectFinder::updateSensorModel(){
+    viewpoints.hfov = 2*std::atan(camSize.width/(2*camCalib.fx()));
+    viewpoints.range = viewRange/map_resolution;
+    viewpoints.linearSpeed = robotSpeed/map_resolution;
+}
 
-        if (mapf.at<uchar>(p.x,p.y)==255){
-            cont_valid_numbers++;
-            pathGraph.push_back(p);
-            cv::circle(color_map, p, 1, cv::Scalar(0,255,0), 2);
-        }//
+bool ObjectFinder::nextViewpoint(cv::Point& cell, double& yaw){
+    if (!(useViewpoints || useBelief) || !mapfready || !camCalib.hasRayTable())
+        return false;
+    updateSensorModel();
+
+    cv::Point robot;
+    double robotYaw=0;
+    if (!robotPose(robot, robotYaw))
+        robot = init_point;
+
+    cv::Mat cost;
+    FrontierPlanner::computeCostMap(mapf, robot, cost);
+
+    // where the object most likely is: reachable cells on a coarse grid, about 200 of them
+    if (useBelief && !belief.empty()){
+        updatePlanner();
+        const int stride = std::max(5, int(std::sqrt(cv::countNonZero(cost>=0)/200.0)));
+        std::vector<cv::Point> positions;
+        for (int y=stride/2; y<cost.rows; y+=stride)
+            for (int x=stride/2; x<cost.cols; x+=stride)
+                if (cost.at<float>(y,x)>=0 && (!planner.hasMap() || planner.isTraversable(cv::Point(x,y))))
+                    positions.push_back(cv::Point(x,y));
+        positions.push_back(robot);
+
+        Viewpoint vp;
+        if (belief.selectBest(mapf, viewpoints, positions, robot, robotYaw, cost, vp, minDetection)){
+            cell = vp.cell;
+            yaw = vp.yaw;
+            return true;
+        }
     }
+    if (!useViewpoints)
+        return false;
+
+    // candidates: the current path (last sighting and frontiers) and the robot position itself;
+    // if none of them shows enough new cells, plan a new path and try again
+    for (int attempt=0; attempt<2; attempt++){
+        if (attempt>0 || pathGraph.empty()){
+            pather();
+            currPathIdx = 0;
+        }
+        std::vector<cv::Point> positions;
+        for (size_t i=0; i<pathGraph.size(); i++)
+            if (goalReachable(pathGraph[i]))
+                positions.push_back(pathGraph[i]);
+        positions.push_back(robot);
+
+        Viewpoint vp;
+        if (viewpoints.selectBest(mapf, positions, robot, robotYaw, cost, vp, minViewGain)){
+            cell = vp.cell;
+            yaw = vp.yaw;
+            return true;
+        }
+    }
+    return false;
+}
 
-    cv::imshow("map", color_map);
+void ObjectFinder::observeFromRobot(bool objectSeen){
+    if (!mapfready || !camCalib.hasRayTable())
+        return;
+    updateSensorModel();
+
+    cv::Point robot;
+    double robotYaw;
+    if (!robotPose(robot, robotYaw))
+        return;
+    if (useViewpoints)
+        viewpoints.markObserved(mapf, robot, robotYaw);
+    // the object was looked for in the frustum and not found there
+    if (useBelief && !objectSeen)
+        belief.observe(mapf, viewpoints, robot, robotYaw);
 }
@@ -7,6 +7,7 @@
 #include <time.h>
 #define _USE_MATH_DEFINES
 #include <ros/ros.h>
+#include <ros/callback_queue.h>
 #include <tf/transform_listener.h>
 #include <tf/transform_datatypes.h>
 #include "tf/LinearMath/Quaternion.h"
@@ -20,10 +21,29 @@
 #include <opencv2/opencv.hpp>
 
 #include <PatternDetector.hpp>
+#include <ObjectPerception.hpp>
+#include <OccupancyMap.hpp>
+#include <FrontierPlanner.hpp>
+#include <ViewpointPlanner.hpp>
+#include <GridPlanner.hpp>
+#include <ExplorationGoals.hpp>
+#include <ClearanceMap.hpp>
+#include <ObservationMemory.hpp>
+#include <SearchBelief.hpp>
+#include <ObjectPoseFilter.hpp>
+#include <Profiler.hpp>
+#include <TaskScheduler.hpp>
+#include <Tracer.hpp>
+#include <SensorLog.hpp>
+#include <RosLog.hpp>
+#include <DebugViewer.hpp>
+#include <csignal>
 
 #include <algorithm>
 #include <nav_msgs/GetMap.h>
 #include <nav_msgs/GridCells.h>
+#include <map_msgs/OccupancyGridUpdate.h>
+#include <geometry_msgs/PoseWithCovarianceStamped.h>
 #include <move_base_msgs/MoveBaseAction.h>
 #include <actionlib/client/simple_action_client.h>
 
@@ -46,39 +66,119 @@ enum STATE_VAR{
 
 class ObjectFinder{
 public:
-    ObjectFinder();
+    /**
+     * @nh is the handle of the nodelet when running in a nodelet manager. Its callbacks go
+     * to a queue of the finder, served by applyAction().
+     */
+    explicit ObjectFinder(const ros::NodeHandle& nh = ros::NodeHandle());
+
+    /**
+     * Process-wide setup from the parameters: task pool (task_workers, task_affinity) and
+     * tracer (trace_file, trace_capacity). Done once, whatever the number of calls; call it
+     * before the first finder. The SIGUSR1 trace dump is only installed when @ownProcess.
+     */
+    static void initProcess(bool ownProcess);
 
     void applyAction();
+
+    /**
+     * Make applyAction() return after the current iteration (from another thread).
+     */
+    void requestStop();
 private:
 
     STATE_VAR _CURRENT_STATE;
 
+    ros::CallbackQueue callbacks;
     ros::NodeHandle nh_;
+    volatile bool stopRequested;
     ros::Publisher pose_pub_;
     ros::Publisher gopose_pub_;
+    ros::Publisher filtered_pub_;
     ros::Publisher diff_pub_;
     ros::Publisher vel_pub_;
     ros::Subscriber cam_info_;
     ros::Subscriber mapSub;
+    ros::Subscriber mapUpdSub;
     //ros::Subscriber occSub;
     image_transport::Subscriber ima_sub_;
     image_transport::Subscriber dep_sub_;
     image_transport::Publisher ima_pub_;
+    image_transport::Publisher map_pub_;
     image_transport::ImageTransport *it;
 
-    cv::Mat rgb_im;
+    cv_bridge::CvImageConstPtr rgbFrame; // keep the shared message data of rgb_im/dep_im alive
+    cv_bridge::CvImageConstPtr depFrame;
+    cv::Mat rgb_im; // read only: may be the buffer of a message shared with other nodelets
     cv::Mat dep_im;
     cv::Mat templ;
+    ObjectPerception perception;
     cv::Mat mapf;
+    cv::Rect mapDirty; // part of mapf changed since the frontiers were last updated
+    int map_height, map_width;
+    double map_resolution, map_origin_x, map_origin_y; // meters per cell, meters
     std::string depth_node_name;
     std::string rgb_node_name;
     std::string caminfo_node_name;
     std::string template_name;
     std::string kinect_frame_name;
     std::string fixed_frame;
+    std::string base_frame;
+    std::string camera_frame;
 
     std::vector<cv::Point> pathGraph;
+    FrontierPlanner frontiers;
+    ViewpointPlanner viewpoints;
+    bool useViewpoints;
+    double viewRange;
+    double robotSpeed;
+    int minViewGain;
+    SearchBelief belief;
+    bool useBelief;
+    double minDetection;
+    GridPlanner planner;
+    bool plannerStale;
+    ClearanceMap clearance;
+    ObservationMemory memory;
+    ObjectPoseFilter poseFilter;
+    cv::Point3f goalObject; // filtered object pose the current goal was computed from
+    double goalObjectYaw;
+    double resendDistance;
+    double resendYaw;
+    int trackPeriod;
+    int trackFrames;
+    double profilePeriod;
+    ros::Time lastProfileReport;
+    std::string trace_file;
+    int64 imageFrame;
+    cv::RNG rng; // sampling of the exploration points
+    std::string replay_file;
+    bool replaying;
+    bool replayOpen;
+    double replayRate;
+    LogReader replayLog;
+    MoveBaseStandIn moveBase;
+    ros::Time replayClock;
+    ros::WallTime replayStart;
+    double replayFirstStamp;
+    int replayFrames;
+    DebugViewer viewer;
+    int objectView;
+    int mapView;
+    bool headless;
+    double debugRate;
+    double debugScale;
+    std::string memory_file;
+    double memorySavePeriod;
+    bool memoryDirty;
+    ros::WallTime lastMemorySave;
+    double robotRadius;
+    double goalDistance;
     boost::array<double, 9ul> kam;
+    std::vector<double> camD;
+    cv::Size camSize;
+    CameraCalibration camCalib;
+    bool undistortRays;
     tf::TransformListener listener;
     tf::TransformListener listener2;
     tf::StampedTransform bl2CamTf;
@@ -86,19 +186,37 @@ private:
     bool im_ready;
     bool dep_ready;
     bool kam_ready;
-    double findObjectYaw(const cv::Mat &depth, const cv::Mat &mask,
-                         double alpha_x, double u0, const cv::Rect &rec);
     void readImage(const sensor_msgs::ImageConstPtr& kinectImage);
     void readDepth(const sensor_msgs::ImageConstPtr& kinectImage);
     void readKam(const sensor_msgs::CameraInfoConstPtr& camInfo);
     void detectObject(const cv::Mat& I, std::vector<cv::Point> &objectCoor);
     void goalDone(const actionlib::SimpleClientGoalState &state);
     void mapper(const nav_msgs::OccupancyGridPtr &map);
+    void mapUpdater(const map_msgs::OccupancyGridUpdateConstPtr &update);
     void mapperobs(const nav_msgs::GridCellsPtr& cells);
-    std::vector<cv::Point> getMostSimilObj(std::vector<std::vector<Point> > squares, const cv::Mat I);
     Rect getBB(std::vector<cv::Point> obj);
-    geometry_msgs::Quaternion getRotMat(CameraCalibration cc, cv::Size sz, std::vector<Point2f> points2d);
     void pather();
+    bool robotPose(cv::Point& cell, double& yaw);
+    bool nextViewpoint(cv::Point& cell, double& yaw);
+    void observeFromRobot(bool objectSeen);
+    void updateSensorModel();
+    void updatePlanner();
+    bool goalReachable(const cv::Point& cell);
+    bool toFixedFrame(const geometry_msgs::PoseStamped& in, geometry_msgs::PoseStamped& out);
+    bool approachPose(const geometry_msgs::PoseStamped& object, geometry_msgs::PoseStamped& goal);
+    void rememberObject(const geometry_msgs::PoseStamped& object, float confidence);
+    void saveMemory(bool force);
+    bool measureObject(const cv::Mat& image, std::vector<cv::Point>& coor, cv::Mat& depth, cv::Mat& mask,
+                       cv::Rect& box, DepthStats& stats);
+    geometry_msgs::PoseStamped objectPose(const cv::Rect& box, const cv::Mat& depth,
+                                          const cv::Mat& mask, float Zobj, bool& planeFit);
+    bool filterObject(const geometry_msgs::PoseStamped& object);
+    void sendGoal(const geometry_msgs::PoseStamped& gopose);
+    bool sendApproachGoal();
+    void trackObject(cv::Mat& image);
+    void dumpTrace();
+    void dispatchGoal(const move_base_msgs::MoveBaseGoal& goal);
+    bool replayStep();
     size_t currPathIdx;
     MoveBaseClient *ac;
     bool moving;
@@ -0,0 +1,168 @@
+// Transformation against cv::Matx reference results: inversion, composition, quaternions,
+// batch transform and projection.
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+#include "GeometryTypes.hpp"
+#include "PlanarPose.hpp"
+
+namespace
+{
+    Transformation makePose(const cv::Vec3d& rvec, const cv::Vec3f& t)
+    {
+        cv::Matx33d R;
+        cv::Rodrigues(rvec, R);
+        return Transformation(cv::Matx33f(R), t);
+    }
+
+    cv::Matx44f homogeneous(const Transformation& T)
+    {
+        cv::Matx44f m = cv::Matx44f::eye();
+        for (int i = 0; i < 3; i++) {
+            for (int j = 0; j < 3; j++)
+                m(i,j) = T.r()(i,j);
+            m(i,3) = T.t()[i];
+        }
+        return m;
+    }
+
+    void expectNear(const cv::Matx44f& a, const cv::Matx44f& b, float eps)
+    {
+        for (int i = 0; i < 16; i++)
+            EXPECT_NEAR(a.val[i], b.val[i], eps) << "element " << i;
+    }
+
+    std::vector<cv::Point3f> randomPoints(int n)
+    {
+        cv::RNG rng(42);
+        std::vector<cv::Point3f> points(n);
+        for (int i = 0; i < n; i++)
+            points[i] = cv::Point3f(rng.uniform(-1.f, 1.f), rng.uniform(-1.f, 1.f), rng.uniform(-1.f, 1.f));
+        return points;
+    }
+
+    const Transformation A = makePose(cv::Vec3d(0.3, -0.2, 0.9), cv::Vec3f(0.5f, -1.0f, 2.0f));
+    const Transformation B = makePose(cv::Vec3d(-1.1, 0.4, 0.1), cv::Vec3f(-0.3f, 0.2f, 0.7f));
+}
+
+TEST(Transformation, InverseIsTransposeAndMinusRtT)
+{
+    const Transformation inv = A.getInverted();
+    const cv::Matx33f rt = A.r().t();
+    const cv::Vec3f t = -(rt*A.t());
+    for (int i = 0; i < 9; i++)
+        EXPECT_NEAR(rt.val[i], inv.r().val[i], 1e-6);
+    for (int i = 0; i < 3; i++)
+        EXPECT_NEAR(t[i], inv.t()[i], 1e-6);
+
+    expectNear(homogeneous(A).inv(), homogeneous(inv), 1e-5f);
+    expectNear(cv::Matx44f::eye(), homogeneous(A*inv), 1e-5f);
+    expectNear(cv::Matx44f::eye(), homogeneous(inv*A), 1e-5f);
+}
+
+TEST(Transformation, CompositionMatchesMatrixProduct)
+{
+    expectNear(homogeneous(A)*homogeneous(B), homogeneous(A*B), 1e-5f);
+
+    const cv::Point3f p(0.1f, 0.2f, -0.4f);
+    const cv::Point3f ab = (A*B)(p), a_b = A(B(p));
+    EXPECT_NEAR(a_b.x, ab.x, 1e-5);
+    EXPECT_NEAR(a_b.y, ab.y, 1e-5);
+    EXPECT_NEAR(a_b.z, ab.z, 1e-5);
+}
+
+TEST(Transformation, QuaternionRoundTrip)
+{
+    // generic rotations and half turns, which go through every branch of getQuaternion
+    std::vector<cv::Vec3d> rotations;
+    rotations.push_back(cv::Vec3d(0.3, -0.2, 0.9));
+    rotations.push_back(cv::Vec3d(-1.1, 0.4, 0.1));
+    rotations.push_back(cv::Vec3d(CV_PI, 0, 0));
+    rotations.push_back(cv::Vec3d(0, CV_PI, 0));
+    rotations.push_back(cv::Vec3d(0, 0, CV_PI));
+    rotations.push_back(cv::Vec3d(0, 0, 0));
+
+    for (size_t k = 0; k < rotations.size(); k++) {
+        const Transformation T = makePose(rotations[k], cv::Vec3f(1, 2, 3));
+        const cv::Vec4f q = T.getQuaternion();
+        EXPECT_NEAR(1.0, cv::norm(q), 1e-5) << "rotation " << k;
+        EXPECT_GE(q[3], 0) << "rotation " << k;
+
+        const Transformation back = Transformation::fromQuaternion(q, T.t());
+        for (int i = 0; i < 9; i++)
+            EXPECT_NEAR(T.r().val[i], back.r().val[i], 1e-5) << "rotation " << k;
+    }
+
+    // quarter turn about z
+    const cv::Vec4f q = makePose(cv::Vec3d(0, 0, CV_PI/2), cv::Vec3f()).getQuaternion();
+    EXPECT_NEAR(0, q[0], 1e-6);
+    EXPECT_NEAR(0, q[1], 1e-6);
+    EXPECT_NEAR(std::sqrt(0.5), q[2], 1e-6);
+    EXPECT_NEAR(std::sqrt(0.5), q[3], 1e-6);
+}
+
+TEST(Transformation, ApplyMatchesMatx)
+{
+    const std::vector<cv::Point3f> points = randomPoints(37); // not a multiple of a vector width
+    std::vector<cv::Point3f> out(points.size());
+    A.apply(&points[0], points.size(), &out[0]);
+
+    for (size_t i = 0; i < points.size(); i++) {
+        const cv::Vec3f expected = A.r()*cv::Vec3f(points[i].x, points[i].y, points[i].z) + A.t();
+        EXPECT_NEAR(expected[0], out[i].x, 1e-5);
+        EXPECT_NEAR(expected[1], out[i].y, 1e-5);
+        EXPECT_NEAR(expected[2], out[i].z, 1e-5);
+    }
+
+    // in place
+    std::vector<cv::Point3f> inPlace(points);
+    A.apply(&inPlace[0], inPlace.size(), &inPlace[0]);
+    for (size_t i = 0; i < points.size(); i++)
+        EXPECT_EQ(out[i], inPlace[i]);
+}
+
+TEST(Transformation, ProjectPointsMatchesOpenCV)
+{
+    const cv::Matx33f K(525, 0, 319.5f, 0, 525, 239.5f, 0, 0, 1);
+    const cv::Vec3d rvec(0.1, -0.2, 0.05);
+    const cv::Vec3f t(0.1f, -0.05f, 3.0f); // every point in front of the camera
+    const Transformation T = makePose(rvec, t);
+
+    const std::vector<cv::Point3f> points = randomPoints(37);
+    std::vector<cv::Point2f> out(points.size()), expected;
+    T.projectPoints(&points[0], points.size(), K, &out[0]);
+    cv::projectPoints(points, rvec, cv::Vec3d(t), cv::Mat(cv::Matx33d(K)), cv::Mat(), expected);
+
+    for (size_t i = 0; i < points.size(); i++) {
+        EXPECT_NEAR(expected[i].x, out[i].x, 1e-2);
+        EXPECT_NEAR(expected[i].y, out[i].y, 1e-2);
+    }
+
+    // behind the camera
+    const cv::Point3f behind(0, 0, -5);
+    cv::Point2f p;
+    T.projectPoints(&behind, 1, K, &p);
+    EXPECT_EQ(cv::Point2f(-1, -1), p);
+}
+
+TEST(Transformation, ReprojectionErrorWithoutDistortion)
+{
+    // reprojectionError uses projectPoints without distortion: same result as cv::projectPoints
+    const cv::Matx33d K(525, 0, 319.5, 0, 525, 239.5, 0, 0, 1);
+    const cv::Vec3d rvec(0.2, 0.1, -0.3), tvec(0.05, 0.1, 2.5);
+    const std::vector<cv::Point3f> points = randomPoints(20);
+
+    std::vector<cv::Point2f> image;
+    cv::projectPoints(points, rvec, tvec, cv::Mat(K), cv::Mat(), image);
+    double sum = 0;
+    for (size_t i = 0; i < image.size(); i++) {
+        image[i] += cv::Point2f(0.5f, -0.25f);
+        sum += 0.5*0.5 + 0.25*0.25;
+    }
+
+    const double expected = std::sqrt(sum/image.size());
+    EXPECT_NEAR(expected, reprojectionError(points, image, K, cv::Mat(), rvec, tvec), 1e-3);
+    EXPECT_NEAR(expected, reprojectionError(points, image, K, cv::Mat::zeros(5, 1, CV_32F), rvec, tvec), 1e-3);
+}
@@ -0,0 +1,121 @@
+// HistogramVerifier::score against a reference converting the template and each candidate
+// ROI to HSV exactly once, as getMostSimilObj intended to.
+#include <gtest/gtest.h>
+#include <cfloat>
+#include <algorithm>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+#include "HistogramVerifier.hpp"
+
+namespace
+{
+    cv::MatND referenceHistogram(const cv::Mat& bgr)
+    {
+        cv::Mat hsv;
+        cv::cvtColor(bgr, hsv, CV_BGR2HSV);
+
+        int histSize[] = { 30, 30 };
+        float h_ranges[] = { 0, 256 }, s_ranges[] = { 0, 180 };
+        const float* ranges[] = { h_ranges, s_ranges };
+        int channels[] = { 0, 1 };
+        cv::MatND hist;
+        cv::calcHist(&hsv, 1, channels, cv::Mat(), hist, 2, histSize, ranges, true, false);
+        cv::normalize(hist, hist, 0, 1, cv::NORM_MINMAX, -1, cv::Mat());
+        return hist;
+    }
+
+    float referenceScore(const cv::Mat& templ, const cv::Mat& frame, const cv::Rect& box)
+    {
+        const cv::Rect r = box & cv::Rect(0, 0, frame.cols, frame.rows);
+        if (r.area() == 0)
+            return FLT_MAX;
+        return (float)cv::compareHist(referenceHistogram(templ), referenceHistogram(frame(r).clone()), CV_COMP_CHISQR);
+    }
+
+    class HistogramVerifierTest : public ::testing::Test
+    {
+    protected:
+        cv::Mat frame, templ;
+        std::vector<cv::Rect> boxes;
+
+        virtual void SetUp()
+        {
+            cv::RNG rng(12345);
+            frame.create(240, 320, CV_8UC3);
+            rng.fill(frame, cv::RNG::UNIFORM, cv::Scalar::all(0), cv::Scalar::all(256));
+            // a few colored blocks so the histograms differ between boxes
+            cv::rectangle(frame, cv::Rect(20, 20, 80, 60), cv::Scalar(0, 0, 200), CV_FILLED);
+            cv::rectangle(frame, cv::Rect(150, 100, 60, 90), cv::Scalar(30, 180, 60), CV_FILLED);
+            templ = frame(cv::Rect(10, 10, 100, 80)).clone();
+
+            boxes.push_back(cv::Rect(10, 10, 100, 80));    // the template itself
+            boxes.push_back(cv::Rect(140, 90, 80, 100));   // inside
+            boxes.push_back(cv::Rect(280, 200, 100, 100)); // clipped by the frame
+            boxes.push_back(cv::Rect(-30, -20, 60, 50));   // clipped, negative origin
+            boxes.push_back(cv::Rect(400, 300, 20, 20));   // outside: empty once clipped
+            boxes.push_back(cv::Rect(50, 50, 0, 10));      // empty
+        }
+    };
+}
+
+TEST_F(HistogramVerifierTest, MatchesSingleConversionReference)
+{
+    HistogramVerifier verifier;
+    verifier.setTemplate(templ);
+    ASSERT_TRUE(verifier.hasTemplate());
+
+    std::vector<float> distances;
+    verifier.score(frame, boxes, distances);
+    ASSERT_EQ(boxes.size(), distances.size());
+
+    for (size_t i = 0; i < boxes.size(); i++) {
+        const float expected = referenceScore(templ, frame, boxes[i]);
+        if (expected == FLT_MAX)
+            EXPECT_EQ(FLT_MAX, distances[i]) << "box " << i;
+        else
+            EXPECT_NEAR(expected, distances[i], 1e-4*std::max(1.0f, expected)) << "box " << i;
+    }
+    EXPECT_NEAR(0.0f, distances[0], 1e-6);
+}
+
+TEST_F(HistogramVerifierTest, ScoreIsStableAcrossCalls)
+{
+    // the template must not be converted again on later calls
+    HistogramVerifier verifier;
+    verifier.setTemplate(templ);
+
+    std::vector<float> first, second;
+    verifier.score(frame, boxes, first);
+    verifier.score(frame, boxes, second);
+    EXPECT_EQ(first, second);
+}
+
+TEST_F(HistogramVerifierTest, ScoreHSVMatchesScore)
+{
+    HistogramVerifier verifier;
+    verifier.setTemplate(templ);
+
+    cv::Mat hsv;
+    cv::cvtColor(frame, hsv, CV_BGR2HSV);
+    std::vector<float> fromBgr, fromHsv;
+    verifier.score(frame, boxes, fromBgr);
+    verifier.scoreHSV(hsv, boxes, fromHsv);
+    EXPECT_EQ(fromBgr, fromHsv);
+}
+
+TEST_F(HistogramVerifierTest, NoTemplateOrFrameGivesMax)
+{
+    HistogramVerifier verifier;
+    std::vector<float> distances;
+    verifier.score(frame, boxes, distances);
+    ASSERT_EQ(boxes.size(), distances.size());
+    for (size_t i = 0; i < distances.size(); i++)
+        EXPECT_EQ(FLT_MAX, distances[i]);
+
+    verifier.setTemplate(templ);
+    verifier.score(cv::Mat(), boxes, distances);
+    ASSERT_EQ(boxes.size(), distances.size());
+    for (size_t i = 0; i < distances.size(); i++)
+        EXPECT_EQ(FLT_MAX, distances[i]);
+}
@@ -0,0 +1,185 @@
+// TaskScheduler: nested parallelFor (batch -> pattern -> tiles), exceptions thrown on the
+// pool, re-sizing with init(), the serial pool and exiting with the pool running.
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <vector>
+#include <unistd.h>
+#include <opencv2/core/core.hpp>
+
+#include "TaskScheduler.hpp"
+
+namespace
+{
+    // every index of the range is run exactly once
+    class CountBody : public cv::ParallelLoopBody {
+        std::vector<int>& runs;
+
+    public:
+        explicit CountBody(std::vector<int>& runs) : runs(runs) {}
+
+        void operator() (const cv::Range& range) const {
+            for (int i = range.start; i != range.end; i++)
+                __sync_fetch_and_add(&runs[i], 1);
+        }
+    };
+
+    const int FRAMES = 8, PATTERNS = 4, TILES = 16;
+
+    class TileBody : public cv::ParallelLoopBody {
+        std::vector<int>& runs;
+        int base;
+
+    public:
+        TileBody(std::vector<int>& runs, int base) : runs(runs), base(base) {}
+
+        void operator() (const cv::Range& range) const {
+            for (int i = range.start; i != range.end; i++)
+                __sync_fetch_and_add(&runs[base + i], 1);
+        }
+    };
+
+    class PatternBody : public cv::ParallelLoopBody {
+        std::vector<int>& runs;
+        int frame;
+
+    public:
+        PatternBody(std::vector<int>& runs, int frame) : runs(runs), frame(frame) {}
+
+        void operator() (const cv::Range& range) const {
+            for (int i = range.start; i != range.end; i++)
+                TaskScheduler::parallelFor(cv::Range(0, TILES), TileBody(runs, (frame*PATTERNS + i)*TILES));
+        }
+    };
+
+    class FrameBody : public cv::ParallelLoopBody {
+        std::vector<int>& runs;
+
+    public:
+        explicit FrameBody(std::vector<int>& runs) : runs(runs) {}
+
+        void operator() (const cv::Range& range) const {
+            for (int i = range.start; i != range.end; i++)
+                TaskScheduler::parallelFor(cv::Range(0, PATTERNS), PatternBody(runs, i));
+        }
+    };
+
+    // throws on one index, after a delay so that the other chunks are still running
+    class ThrowBody : public cv::ParallelLoopBody {
+        std::vector<int>& runs;
+        int bad;
+        bool standard;
+
+    public:
+        ThrowBody(std::vector<int>& runs, int bad, bool standard) : runs(runs), bad(bad), standard(standard) {}
+
+        void operator() (const cv::Range& range) const {
+            for (int i = range.start; i != range.end; i++) {
+                if (i == bad) {
+                    usleep(1000);
+                    if (standard)
+                        throw std::runtime_error("bad index");
+                    throw cv::Exception(CV_StsError, "bad index", "ThrowBody", __FILE__, __LINE__);
+                }
+                __sync_fetch_and_add(&runs[i], 1);
+            }
+        }
+    };
+
+    void expectEachOnce(const std::vector<int>& runs, int skip = -1)
+    {
+        for (size_t i = 0; i < runs.size(); i++)
+            EXPECT_EQ(int(i) == skip ? 0 : 1, runs[i]) << "index " << i;
+    }
+
+    class TaskSchedulerTest : public ::testing::TestWithParam<int>
+    {
+    protected:
+        virtual void SetUp() { TaskScheduler::init(GetParam()); }
+        virtual void TearDown() { TaskScheduler::shutdown(); }
+    };
+}
+
+TEST_P(TaskSchedulerTest, RunsEveryIndexOnce)
+{
+    for (int grain = 1; grain <= 64; grain *= 4) {
+        std::vector<int> runs(1000, 0);
+        TaskScheduler::parallelFor(cv::Range(0, runs.size()), CountBody(runs), grain);
+        expectEachOnce(runs);
+    }
+
+    // empty range
+    std::vector<int> none;
+    TaskScheduler::parallelFor(cv::Range(0, 0), CountBody(none));
+}
+
+TEST_P(TaskSchedulerTest, NestedBatchPatternTiles)
+{
+    for (int repeat = 0; repeat < 20; repeat++) {
+        std::vector<int> runs(FRAMES*PATTERNS*TILES, 0);
+        TaskScheduler::parallelFor(cv::Range(0, FRAMES), FrameBody(runs));
+        expectEachOnce(runs);
+    }
+}
+
+TEST_P(TaskSchedulerTest, RethrowsCvException)
+{
+    std::vector<int> runs(200, 0);
+    EXPECT_THROW(TaskScheduler::parallelFor(cv::Range(0, runs.size()), ThrowBody(runs, 150, false)),
+                 cv::Exception);
+    // parallelFor returns once the other chunks are done
+    for (size_t i = 0; i < runs.size(); i++)
+        if (i < 150)
+            EXPECT_EQ(1, runs[i]) << "index " << i;
+
+    // the pool is still usable
+    std::vector<int> after(100, 0);
+    TaskScheduler::parallelFor(cv::Range(0, after.size()), CountBody(after));
+    expectEachOnce(after);
+}
+
+TEST_P(TaskSchedulerTest, RethrowsStandardException)
+{
+    // as cv::Exception on the pool, as is in the serial path: both are std::exception
+    std::vector<int> runs(200, 0);
+    EXPECT_THROW(TaskScheduler::parallelFor(cv::Range(0, runs.size()), ThrowBody(runs, 10, true)),
+                 std::exception);
+    if (TaskScheduler::workers() > 0)
+        EXPECT_THROW(TaskScheduler::parallelFor(cv::Range(0, runs.size()), ThrowBody(runs, 10, true)),
+                     cv::Exception);
+}
+
+INSTANTIATE_TEST_CASE_P(Workers, TaskSchedulerTest, ::testing::Values(0, 1, 3));
+
+TEST(TaskScheduler, InitResizesThePool)
+{
+    const int sizes[] = { 2, 0, 4, 1 };
+    for (int k = 0; k < 4; k++) {
+        TaskScheduler::init(sizes[k]);
+        EXPECT_EQ(sizes[k], TaskScheduler::workers());
+
+        std::vector<int> runs(FRAMES*PATTERNS*TILES, 0);
+        TaskScheduler::parallelFor(cv::Range(0, FRAMES), FrameBody(runs));
+        expectEachOnce(runs);
+    }
+
+    TaskScheduler::shutdown();
+    EXPECT_EQ(0, TaskScheduler::workers());
+
+    // restarted with the default size on the next parallelFor
+    std::vector<int> runs(100, 0);
+    TaskScheduler::parallelFor(cv::Range(0, runs.size()), CountBody(runs));
+    expectEachOnce(runs);
+    TaskScheduler::shutdown();
+}
+
+TEST(TaskSchedulerDeathTest, ExitsWithIdleWorkers)
+{
+    // the pool is left running: static destruction must not wait on the sleeping workers
+    EXPECT_EXIT({
+        TaskScheduler::init(3);
+        std::vector<int> runs(100, 0);
+        TaskScheduler::parallelFor(cv::Range(0, runs.size()), CountBody(runs));
+        usleep(10000);
+        exit(0);
+    }, ::testing::ExitedWithCode(0), "");
+}